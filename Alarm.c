@@ -0,0 +1,126 @@
+#include "Alarm.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+#define S(next, action)		{ALARM_##next, ACT_##action}
+#define STAY				{ALARM_STATES, ACT_NONE}		// same state, nothing to do
+
+/*
+ * Transition table : one row per state, one column per event (EV_xxx - 1).
+*/
+static const ALARM_TRANSITION alarmTable[ALARM_STATES][ALARM_EVENTS] =
+{
+	// DISARMED
+	{
+		S(ARMED, ARM_SEND),         // CODE_OK
+		S(DISARMED, WRONG_CODE),    // CODE_WRONG
+		STAY,                       // INTRUSION
+		STAY,                       // ENTRY_TIMEOUT
+		S(PWD_CHANGE, NONE),        // PWD_CHANGE
+		STAY,                       // PWD_CHANGE_DONE
+		S(ARMED, ARM),              // REMOTE_ARM
+		STAY,                       // REMOTE_DISARM
+		STAY,                       // REMOTE_ALARM
+		S(DISARMED, SHOW_LOST),     // MEMBER_LOST
+		STAY,                       // ZONE_INSTANT
+		S(ALARMING, ZONE_ALARM),    // ZONE_24H
+	},
+	// ARMED
+	{
+		S(DISARMED, DISARM_SEND),   // CODE_OK
+		S(ARMED, WRONG_CODE),       // CODE_WRONG
+		S(ENTRY_DELAY, ENTRY),      // INTRUSION
+		STAY,                       // ENTRY_TIMEOUT
+		STAY,                       // PWD_CHANGE
+		STAY,                       // PWD_CHANGE_DONE
+		STAY,                       // REMOTE_ARM
+		S(DISARMED, DISARM),        // REMOTE_DISARM
+		S(ALARMING, ALARM),         // REMOTE_ALARM
+		S(ALARMING, ALARM),         // MEMBER_LOST
+		S(ALARMING, ZONE_ALARM),    // ZONE_INSTANT
+		S(ALARMING, ZONE_ALARM),    // ZONE_24H
+	},
+	// ENTRY_DELAY
+	{
+		S(DISARMED, DISARM_SEND),   // CODE_OK
+		S(ENTRY_DELAY, WRONG_CODE), // CODE_WRONG
+		STAY,                       // INTRUSION
+		S(ALARMING, ALARM_SEND),    // ENTRY_TIMEOUT
+		STAY,                       // PWD_CHANGE
+		STAY,                       // PWD_CHANGE_DONE
+		STAY,                       // REMOTE_ARM
+		S(DISARMED, DISARM),        // REMOTE_DISARM
+		S(ALARMING, ALARM),         // REMOTE_ALARM
+		S(ALARMING, ALARM),         // MEMBER_LOST
+		S(ALARMING, ZONE_ALARM),    // ZONE_INSTANT
+		S(ALARMING, ZONE_ALARM),    // ZONE_24H
+	},
+	// ALARMING
+	{
+		S(DISARMED, DISARM_SEND),   // CODE_OK
+		S(ALARMING, WRONG_CODE),    // CODE_WRONG
+		STAY,                       // INTRUSION
+		STAY,                       // ENTRY_TIMEOUT
+		STAY,                       // PWD_CHANGE
+		STAY,                       // PWD_CHANGE_DONE
+		STAY,                       // REMOTE_ARM
+		S(DISARMED, DISARM),        // REMOTE_DISARM
+		STAY,                       // REMOTE_ALARM
+		STAY,                       // MEMBER_LOST
+		STAY,                       // ZONE_INSTANT
+		STAY,                       // ZONE_24H
+	},
+	// PWD_CHANGE
+	{
+		STAY,                       // CODE_OK
+		STAY,                       // CODE_WRONG
+		STAY,                       // INTRUSION
+		STAY,                       // ENTRY_TIMEOUT
+		STAY,                       // PWD_CHANGE
+		S(DISARMED, NONE),          // PWD_CHANGE_DONE
+		S(ARMED, ARM),              // REMOTE_ARM
+		STAY,                       // REMOTE_DISARM
+		STAY,                       // REMOTE_ALARM
+		S(PWD_CHANGE, SHOW_LOST),   // MEMBER_LOST
+		STAY,                       // ZONE_INSTANT
+		S(ALARMING, ZONE_ALARM),    // ZONE_24H
+	}
+};
+
+// State word of each state (HB_STATE_xxx bits)
+static const unsigned char alarmFlags[ALARM_STATES] =
+{
+	HB_STATE_UNLOCKED,							// DISARMED
+	0,											// ARMED
+	HB_STATE_TIMER,								// ENTRY_DELAY
+	HB_STATE_ALARM,								// ALARMING
+	HB_STATE_UNLOCKED | HB_STATE_PWD_CHANGE		// PWD_CHANGE
+};
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/****************** TRANSITIONS *****************************/
+
+ALARM_TRANSITION AlarmTransition(unsigned char state, unsigned char event)
+{
+	ALARM_TRANSITION transition = {ALARM_STATES, ACT_NONE};
+
+	if(state < ALARM_STATES && event >= 1 && event <= ALARM_EVENTS) {
+		transition = alarmTable[state][event - 1];
+	}
+	if(transition.next == ALARM_STATES) {
+		transition.next = state;
+	}
+	return transition;
+}
+
+/****************** STATE WORD ******************************/
+
+unsigned char AlarmStateFlags(unsigned char state)
+{
+	return (state < ALARM_STATES) ? alarmFlags[state] : 0;
+}
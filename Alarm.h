@@ -0,0 +1,75 @@
+#ifndef _ALARM_H
+#define _ALARM_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include "HeartBeat.h"
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+//! States of the alarm
+typedef enum _ALARM_STATE
+{
+	ALARM_DISARMED		= 0,	/*!< Unlocked, the inputs are ignored				*/
+	ALARM_ARMED			= 1,	/*!< Locked, waiting for an intrusion				*/
+	ALARM_ENTRY_DELAY	= 2,	/*!< Intrusion detected, the code is expected		*/
+	ALARM_ALARMING		= 3,	/*!< Buzzer on until the system is unlocked			*/
+	ALARM_PWD_CHANGE	= 4,	/*!< Unlocked, password change procedure running	*/
+	ALARM_STATES		= 5
+} ALARM_STATE;
+
+//! Events of the alarm (0 is not an event : it is what an empty queue returns)
+typedef enum _ALARM_EVENT
+{
+	EV_CODE_OK			= 1,	/*!< Correct code entered on the keypad				*/
+	EV_CODE_WRONG		= 2,	/*!< Wrong code entered on the keypad				*/
+	EV_INTRUSION		= 3,	/*!< Intrusion button pressed						*/
+	EV_ENTRY_TIMEOUT	= 4,	/*!< Entry delay elapsed							*/
+	EV_PWD_CHANGE		= 5,	/*!< Password change button pressed					*/
+	EV_PWD_CHANGE_DONE	= 6,	/*!< Password change procedure over (set or failed)	*/
+	EV_REMOTE_ARM		= 7,	/*!< Another node armed the system					*/
+	EV_REMOTE_DISARM	= 8,	/*!< Another node disarmed the system				*/
+	EV_REMOTE_ALARM		= 9,	/*!< Another node is alarming						*/
+	EV_MEMBER_LOST		= 10,	/*!< A node stopped sending heartbeats				*/
+	EV_ZONE_INSTANT		= 11,	/*!< Instant sensor zone tripped					*/
+	EV_ZONE_24H			= 12,	/*!< 24h sensor zone tripped						*/
+	ALARM_EVENTS		= 12
+} ALARM_EVENT;
+
+//! What is done on a transition, besides writing the new state
+typedef enum _ALARM_ACTION
+{
+	ACT_NONE			= 0,
+	ACT_WRONG_CODE		= 1,	/*!< Tell the user									*/
+	ACT_ARM				= 2,	/*!< Armed by another node							*/
+	ACT_ARM_SEND		= 3,	/*!< Armed here : tell the other nodes				*/
+	ACT_DISARM			= 4,	/*!< Disarmed by another node						*/
+	ACT_DISARM_SEND		= 5,	/*!< Disarmed here : tell the other nodes			*/
+	ACT_ENTRY			= 6,	/*!< Start the entry delay, tell the other nodes	*/
+	ACT_ALARM			= 7,	/*!< Alarm raised elsewhere or node lost			*/
+	ACT_ALARM_SEND		= 8,	/*!< Entry delay elapsed : tell the other nodes		*/
+	ACT_SHOW_LOST		= 9,	/*!< Node lost while disarmed : tell the user		*/
+	ACT_ZONE_ALARM		= 10	/*!< Zone alarm : tell the other nodes (zones too)	*/
+} ALARM_ACTION;
+
+//! One entry of the transition table
+typedef struct _ALARM_TRANSITION
+{
+	unsigned char next;			/*!< ALARM_STATE									*/
+	unsigned char action;		/*!< ALARM_ACTION									*/
+} ALARM_TRANSITION;
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+//! Returns the transition of 'state' on 'event' (stays in 'state' with ACT_NONE if the event is unknown)
+ALARM_TRANSITION AlarmTransition(unsigned char state, unsigned char event);
+
+//! Returns the HB_STATE_xxx bits describing 'state'
+unsigned char AlarmStateFlags(unsigned char state);
+
+#endif
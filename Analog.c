@@ -0,0 +1,180 @@
+#include "Analog.h"
+#include "Alarm.h"
+#include "CanDspic.h"	// DMA_BASE_ADDRESS
+#include "Trace.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+#define ANALOG_WORDS	(ANALOG_BLOCK * ANALOG_CHANNELS)	// Interleaved, in scan order
+
+// Ping-pong buffers, after the CAN buffers
+static INT16U analogBufferA[ANALOG_WORDS] __attribute__((space(dma),address(DMA_BASE_ADDRESS+0x0080)));
+static INT16U analogBufferB[ANALOG_WORDS] __attribute__((space(dma),address(DMA_BASE_ADDRESS+0x0180)));
+
+static OS_EVENT* analogQueue;					// Alarm events (ALARM_EVENT cast to a pointer)
+static unsigned char analogBlockB = 0;			// 1 : the next block completed is B
+static INT16U analogMean[ANALOG_CHANNELS];		// DC level, from the previous block
+static unsigned char analogOver[ANALOG_CHANNELS];	// Blocks in a row above the threshold
+static const INT32U analogThreshold[ANALOG_CHANNELS] = ANALOG_THRESHOLDS;
+static INT8U analogTripped = 0;					// Inputs tripped since the last AnalogClear()
+
+static INT32U analogWindowStart;				// OSTimeGet() at the start of the figures
+static INT32U analogWindowSamples;
+static INT32U analogWindowCycles;
+
+INT16U analogSampleRate = 0;
+INT16U analogCpuLoad = 0;
+INT32U analogEnergy[ANALOG_CHANNELS];
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * ADC1 converts the ANALOG_SCAN inputs one after the other, on its own
+ * (auto-sample, auto-convert), and DMA2 stores the results alternately in the
+ * two buffers. The CPU is only interrupted once per block of ANALOG_BLOCK
+ * samples per input. TMR3 must be running (CPU load figures).
+*/
+void AnalogInit(OS_EVENT* alarmQueue)
+{
+	unsigned char i;
+	analogQueue = alarmQueue;
+	for(i = 0; i < ANALOG_CHANNELS; i++) {
+		analogMean[i] = 2048;
+		analogOver[i] = 0;
+	}
+	analogWindowStart = OSTimeGet();
+	analogWindowSamples = 0;
+	analogWindowCycles = 0;
+
+	AD1PCFGL &= ~ANALOG_SCAN;		// analog inputs
+	AD1CON1 = 0;
+	AD1CON1bits.AD12B = 1;			// 12-bit, unsigned integer results
+	AD1CON1bits.SSRC = 7;			// auto-convert at the end of the sample time
+	AD1CON1bits.ASAM = 1;			// next sample starts right after the conversion
+	AD1CON1bits.ADDMABM = 1;		// results written to DMA RAM in conversion order
+	AD1CON2 = 0;
+	AD1CON2bits.CSCNA = 1;			// scan the AD1CSSL inputs
+	AD1CON2bits.SMPI = ANALOG_CHANNELS - 1;
+	AD1CON3 = 0;
+	AD1CON3bits.SAMC = ANALOG_SAMC;
+	AD1CON3bits.ADCS = ANALOG_ADCS;
+	AD1CON4 = 0;
+	AD1CHS0 = 0;
+	AD1CSSL = ANALOG_SCAN;
+
+	DMA2CONbits.SIZE = 0x0;			// Data Transfer Size: Word Transfer Mode
+	DMA2CONbits.DIR = 0x0;			// Data Transfer Direction: Peripheral to DMA RAM
+	DMA2CONbits.HALF = 0x0;			// Initiate interrupt when all data has been transfered
+	DMA2CONbits.NULLW = 0x0;		// Normal operation (no NULL data write)
+	DMA2CONbits.AMODE = 0x0;		// DMA Addressing Mode: Register Indirect with Post-Increment
+	DMA2CONbits.MODE = 0x2;			// Operating Mode: Continuous, Ping-Pong
+	DMA2REQ = 13;					// Assign ADC1 conversion done event for DMA Channel 2
+	DMA2PAD = (volatile unsigned int)&ADC1BUF0;
+	DMA2CNT = ANALOG_WORDS - 1;
+	DMA2STA = 0x0080;				// Start Address Offset of analogBufferA
+	DMA2STB = 0x0180;				// Start Address Offset of analogBufferB
+	IPC6bits.DMA2IP = TIMER_INT_PRIO;
+	IFS1bits.DMA2IF = 0;
+	IEC1bits.DMA2IE = 1;
+	DMA2CONbits.CHEN = 0x1;
+
+	AD1CON1bits.ADON = 1;
+}
+
+/*
+ * Detector of one input : mean square of the block around the DC level of
+ * the previous block. A knock or a breaking glass shows as a burst of AC
+ * energy, whatever the offset of the sensor. The input trips after
+ * ANALOG_TRIP_BLOCKS blocks in a row above its threshold, once per burst.
+*/
+static void AnalogDetect(INT16U* block, unsigned char input)
+{
+	INT16U* sample = block + input;
+	INT16U* end = block + ANALOG_WORDS;
+	INT16S mean = (INT16S)analogMean[input];
+	INT16S ac;
+	INT32U sum = 0;
+	INT32U energy = 0;
+	INT8U bit = 1 << input;
+
+	for(; sample < end; sample += ANALOG_CHANNELS) {
+		sum += *sample;
+		ac = (INT16S)*sample - mean;
+		energy += (INT32S)ac * ac;
+	}
+	analogMean[input] = (INT16U)(sum / ANALOG_BLOCK);
+	energy /= ANALOG_BLOCK;
+	analogEnergy[input] = energy;
+	if(energy <= analogThreshold[input]) {
+		analogOver[input] = 0;
+		return;
+	}
+	if(++analogOver[input] != ANALOG_TRIP_BLOCKS) {
+		if(analogOver[input] > ANALOG_TRIP_BLOCKS) {
+			analogOver[input] = ANALOG_TRIP_BLOCKS + 1;	// tripped : wait for the end of the burst
+		}
+		return;
+	}
+	analogTripped |= bit;
+	if(bit & ANALOG_24H) {
+		OSQPost(analogQueue, (void*)(INT16U)EV_ZONE_24H);
+	}
+	else if(bit & ANALOG_INSTANT) {
+		OSQPost(analogQueue, (void*)(INT16U)EV_ZONE_INSTANT);
+	}
+	else {
+		OSQPost(analogQueue, (void*)(INT16U)EV_INTRUSION);
+	}
+}
+
+/*
+ * A block is complete : DMA2 goes on in the other buffer while this one is
+ * handled. Every ANALOG_REPORT_TICKS, the samples and the cycles spent here
+ * give the sample rate and the CPU load.
+*/
+void AnalogDMA2_ISR_Handler(void)
+{
+	INT16U start = TMR3;
+	INT16U* block = analogBlockB ? analogBufferB : analogBufferA;
+	INT32U now;
+	INT32U elapsed;
+	unsigned char i;
+
+	TRACE_RECORD_ADD(TRACE_ISR_ENTER, TRACE_ISR_ANALOG_DMA2, 0);
+	analogBlockB = !analogBlockB;
+	for(i = 0; i < ANALOG_CHANNELS; i++) {
+		AnalogDetect(block, i);
+	}
+	IFS1bits.DMA2IF = 0;
+
+	analogWindowSamples += ANALOG_BLOCK;
+	analogWindowCycles += (INT16U)(TMR3 - start);
+	now = OSTimeGet();
+	elapsed = now - analogWindowStart;
+	if(elapsed >= ANALOG_REPORT_TICKS) {
+		analogSampleRate = (INT16U)(analogWindowSamples * OS_TICKS_PER_SEC / elapsed);
+		analogCpuLoad = (INT16U)(analogWindowCycles / (elapsed * (BSP_CPU_ClkFrq() / OS_TICKS_PER_SEC / 1000)));
+		analogWindowStart = now;
+		analogWindowSamples = 0;
+		analogWindowCycles = 0;
+	}
+	TRACE_RECORD_ADD(TRACE_ISR_EXIT, TRACE_ISR_ANALOG_DMA2, 0);
+}
+
+/*
+ * Bitmap of the inputs tripped since the last AnalogClear() (scan order), sent
+ * with the intrusion frames.
+*/
+INT8U AnalogTripped(void)
+{
+	return analogTripped;
+}
+
+void AnalogClear(void)
+{
+	analogTripped = 0;
+}
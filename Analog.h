@@ -0,0 +1,47 @@
+#ifndef _ANALOG_H
+#define _ANALOG_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+// Analog sensors (glass-break, vibration) : ADC1 scans these inputs, bit n is ANn
+#define ANALOG_SCAN				0x0030		// AN4, AN5
+#define ANALOG_CHANNELS			2			// Inputs in ANALOG_SCAN
+#define ANALOG_BLOCK			64			// Samples per input and per DMA block
+#define ANALOG_SAMC				31			// Sample time (Tad)
+#define ANALOG_ADCS				63			// Tad = (ANALOG_ADCS + 1) Tcy : 1.6us at 40MHz
+											// -> Fcy / ((ADCS + 1) (SAMC + 14)) = 13.9kHz, shared by the inputs
+
+// Detector : mean square of the AC part of a block (ADC counts squared), per input in scan order
+#define ANALOG_THRESHOLDS		{40000, 40000}
+#define ANALOG_TRIP_BLOCKS		2			// Blocks in a row above the threshold to trip
+#define ANALOG_INSTANT			0x03		// Inputs (scan order) tripping an instant zone
+#define ANALOG_24H				0x00		// ... a 24h zone (the others are delayed)
+
+#define ANALOG_REPORT_TICKS		OS_TICKS_PER_SEC	// Period of the rate and load figures
+
+/********************************************************
+*						VARIABLES						*
+********************************************************/
+
+// Figures of the last ANALOG_REPORT_TICKS (read with uC/Probe or the debugger)
+extern INT16U analogSampleRate;			// Samples per second and per input
+extern INT16U analogCpuLoad;			// Share of the CPU spent in the detector (0.1%)
+extern INT32U analogEnergy[ANALOG_CHANNELS];	// Last mean square, per input
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void AnalogInit(OS_EVENT* alarmQueue);
+void AnalogDMA2_ISR_Handler(void);
+INT8U AnalogTripped(void);
+void AnalogClear(void);
+
+#endif
@@ -0,0 +1,134 @@
+#include "Buttons.h"
+#include "Alarm.h"
+#include "Trace.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+static OS_EVENT* buttonQueue;					// Alarm events (ALARM_EVENT cast to a pointer)
+static OS_EVENT* buttonHold;					// Posted when the intrusion button is held
+static unsigned char buttonDown[BUTTONS];		// Level reported last (1 : pressed)
+static INT8U buttonLockout[BUTTONS];			// Ticks before the edges are listened to again
+static INT16U confirmCycles;					// BUTTON_CONFIRM_US in TMR3 counts
+static INT16U holdCountdown = 0;				// Ticks before 'hold' is posted (0 : not held)
+static const INT8U buttonEvent[BUTTONS] = {EV_INTRUSION, EV_PWD_CHANGE};
+INT32U buttonEdgeTime[BUTTONS];
+INT16U buttonEdgeCapture[BUTTONS];
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * Presses become 'alarmQueue' events (EV_INTRUSION, EV_PWD_CHANGE) ; 'hold'
+ * is a semaphore posted each time the intrusion button is held for
+ * BUTTON_HOLD_TICKS. Both inputs are watched by their input capture module, on
+ * every edge, TMR3 being the time base : TMR3 must be running.
+*/
+void ButtonsInit(OS_EVENT* alarmQueue, OS_EVENT* hold)
+{
+	buttonQueue = alarmQueue;
+	buttonHold = hold;
+	TRISDbits.TRISD12 = 1;	// set pin to input. INTRUSION
+	TRISDbits.TRISD13 = 1;	// set pin to input. CHANGING PASSWORD
+	buttonDown[BUTTON_INTRUSION] = !PORTDbits.RD12;
+	buttonDown[BUTTON_PWD_CHANGE] = !PORTDbits.RD13;
+	confirmCycles = (INT16U)(BSP_CPU_ClkFrq() / 1000000L * BUTTON_CONFIRM_US);
+
+	IC5CON = 0x0001;		// TMR3, interrupt on every capture, capture on every edge
+	IC6CON = 0x0001;
+	IPC9bits.IC5IP = TIMER_INT_PRIO;	// same level as the tick : never nested with ButtonsTickHook
+	IPC10bits.IC6IP = TIMER_INT_PRIO;
+	IFS2bits.IC5IF = 0;
+	IFS2bits.IC6IF = 0;
+	IEC2bits.IC5IE = 1;
+	IEC2bits.IC6IE = 1;
+}
+
+static unsigned char ButtonPressed(INT8U button)
+{
+	return (button == BUTTON_INTRUSION) ? !PORTDbits.RD12 : !PORTDbits.RD13;
+}
+
+/*
+ * Reports a new level of a button. A press goes straight to the alarm task,
+ * which runs as soon as the interrupt returns.
+*/
+static void ButtonReport(INT8U button, unsigned char pressed, INT16U capture)
+{
+	if(pressed == buttonDown[button]) {
+		return;
+	}
+	buttonDown[button] = pressed;
+	if(button == BUTTON_INTRUSION) {
+		holdCountdown = pressed ? BUTTON_HOLD_TICKS : 0;
+	}
+	if(pressed) {
+		buttonEdgeTime[button] = OSTimeGet();
+		buttonEdgeCapture[button] = capture;
+		OSQPost(buttonQueue, (void*)(INT16U)buttonEvent[button]);
+	}
+}
+
+/*
+ * An edge outside of a lockout starts it, and the pin is read again
+ * BUTTON_CONFIRM_US after the captured edge, in the interrupt itself : the
+ * new level is reported with the time of the edge only if it still holds, so
+ * that a noise spike does not trip the alarm. A press read back while the
+ * contact still bounces is reported at the end of the lockout, where the
+ * settled level is read again (see ButtonsTickHook).
+*/
+static void ButtonEdge(INT8U button, INT16U capture)
+{
+	if(buttonLockout[button]) {
+		return;
+	}
+	buttonLockout[button] = BUTTON_LOCKOUT_TICKS;
+	while((INT16U)(TMR3 - capture) < confirmCycles);
+	ButtonReport(button, ButtonPressed(button), capture);
+}
+
+void ButtonIC5_ISR_Handler(void)
+{
+	INT16U capture = 0;
+	TRACE_RECORD_ADD(TRACE_ISR_ENTER, TRACE_ISR_BUTTON_IC5, 0);
+	while(IC5CONbits.ICBNE) {
+		capture = IC5BUF;	// oldest first : the edges after it are bounces, dropped by the lockout
+		ButtonEdge(BUTTON_INTRUSION, capture);
+	}
+	IFS2bits.IC5IF = 0;
+	TRACE_RECORD_ADD(TRACE_ISR_EXIT, TRACE_ISR_BUTTON_IC5, 0);
+}
+
+void ButtonIC6_ISR_Handler(void)
+{
+	INT16U capture = 0;
+	TRACE_RECORD_ADD(TRACE_ISR_ENTER, TRACE_ISR_BUTTON_IC6, 0);
+	while(IC6CONbits.ICBNE) {
+		capture = IC6BUF;
+		ButtonEdge(BUTTON_PWD_CHANGE, capture);
+	}
+	IFS2bits.IC6IF = 0;
+	TRACE_RECORD_ADD(TRACE_ISR_EXIT, TRACE_ISR_BUTTON_IC6, 0);
+}
+
+/*
+ * Called every tick by App_TimeTickHook. It has nothing to do while the
+ * buttons are idle : it only ends the lockouts (reading the settled level,
+ * e.g. a release whose edge was taken for a bounce) and times the hold of the
+ * intrusion button.
+*/
+void ButtonsTickHook(void)
+{
+	INT8U button;
+
+	for(button = 0; button < BUTTONS; button++) {
+		if(buttonLockout[button] && !--buttonLockout[button]) {
+			ButtonReport(button, ButtonPressed(button), TMR3);
+		}
+	}
+	if(holdCountdown && !--holdCountdown) {
+		OSSemPost(buttonHold);
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef _BUTTONS_H
+#define _BUTTONS_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define BUTTON_INTRUSION		0			// RD12 (IC5), active low
+#define BUTTON_PWD_CHANGE		1			// RD13 (IC6), active low
+#define BUTTONS					2
+
+#define BUTTON_CONFIRM_US		20			// The new level must still hold this long after an edge (noise spikes)
+#define BUTTON_LOCKOUT_TICKS	20			// Edges ignored (bounces) after an accepted edge
+#define BUTTON_HOLD_TICKS		3000		// Intrusion button held this long : 'hold' is posted
+
+/********************************************************
+*						VARIABLES						*
+********************************************************/
+
+extern INT32U buttonEdgeTime[BUTTONS];		// OSTimeGet() of the last press
+extern INT16U buttonEdgeCapture[BUTTONS];	// TMR3 latched by the input capture on that press
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void ButtonsInit(OS_EVENT* alarmQueue, OS_EVENT* hold);
+void ButtonsTickHook(void);
+void ButtonIC5_ISR_Handler(void);
+void ButtonIC6_ISR_Handler(void);
+
+#endif
@@ -47,6 +47,17 @@ void CanSendMessage()
 	C1TR67CONbits.TXREQ7 = 1;
 }
 
+void CanSendReply()
+{
+	// wait until reply buffer is free
+	while(C1TR67CONbits.TXREQ6);
+
+	// Request to Send
+	C1TR67CONbits.TX6PRI1 = 1;
+	C1TR67CONbits.TX6PRI0 = 1;
+	C1TR67CONbits.TXREQ6 = 1;
+}
+
 /****************** INITIALIZE *******************************/
 
 void CanInitialisation(CAN_OP_MODE mode, CAN_BAUDRATE baudrate)
@@ -57,11 +68,11 @@ void CanInitialisation(CAN_OP_MODE mode, CAN_BAUDRATE baudrate)
 	// Set Bit rate values
 	CanSetBaudRate(baudrate);
 	
-	// Configure first 7 TxRx Buffers as receive buffers, last buffer as transmit buffer
+	// Configure first 6 TxRx Buffers as receive buffers, last two buffers as transmit buffers
 	C1TR01CON = 0x0000;
 	C1TR23CON = 0x0000;
 	C1TR45CON = 0x0000;
-	C1TR67CON = 0x8000;
+	C1TR67CON = 0x8080;
 	
 	// Configures the DMA buffer size to 12 buffers and makes FIFO start at buffer 16
 	C1FCTRLbits.DMABS 	= 0b011;
@@ -21,6 +21,9 @@
 #define		CAN_RX_BUFFER_5					C1RXFUL1bits.RXFUL5		// Defines the bit containing the reception flag of a CAN message in buffer 5
 #define		CAN_RX_BUFFER_6					C1RXFUL1bits.RXFUL6		// Defines the bit containing the reception flag of a CAN message in buffer 6
 
+#define		CAN_TX_PENDING					C1TR67CONbits.TXREQ7	// Defines the bit set while the transmit buffer is being sent
+#define		CAN_REPLY_PENDING				C1TR67CONbits.TXREQ6	// Defines the bit set while the reply buffer is being sent
+
 #define 	DMA_BASE_ADDRESS				0x7800
 
 /********************************************************
@@ -75,6 +78,9 @@ typedef union _BUFFER_CAN
 extern BUFFER_CAN receiveBuffers[7] 	__attribute__((space(dma),address(DMA_BASE_ADDRESS+0x0000)));
 extern BUFFER_CAN transmitBuffer 		__attribute__((space(dma),address(DMA_BASE_ADDRESS+0x0070)));
 
+//! Buffer 6 is used as a second transmit buffer, reserved to the messages sent from the CAN interrupt
+#define		replyBuffer						receiveBuffers[6]
+
 /********************************************************
 *						PROTOTYPES						*
 ********************************************************/
@@ -94,6 +100,9 @@ void CanLoadFilter(unsigned char numero, unsigned int id);
 //! Sends the message stored in the transmit buffer
 void CanSendMessage();
 
+//! Sends the message stored in the reply buffer
+void CanSendReply();
+
 //! Loads a mask with the corresponding id
 void CanLoadMask(unsigned char number, unsigned int mask);
 
@@ -0,0 +1,58 @@
+#include "Debounce.h"
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * 'state' is the image assumed before the first sample, 'samples' the number
+ * of samples in a row an input must keep a new level before it is accepted.
+*/
+void DebounceInit(DEBOUNCE* debounce, INT16U state, INT8U samples)
+{
+	debounce->state = state;
+	debounce->cnt0 = 0;
+	debounce->cnt1 = 0;
+	debounce->cnt2 = 0;
+	if(samples < 1) {
+		samples = 1;
+	}
+	else if(samples > DEBOUNCE_MAX_SAMPLES) {
+		samples = DEBOUNCE_MAX_SAMPLES;
+	}
+	debounce->samples = samples;
+}
+
+/*
+ * Debounces the 16 inputs of 'sample' at once. Each input has a 3-bit counter,
+ * spread over cnt0..cnt2 (one bit of the counter per word), counting the
+ * samples in a row it differs from the debounced state. The counters are
+ * incremented and compared with a handful of logical operations on whole
+ * words, whatever the number of inputs. Returns the inputs which changed
+ * (their new level is in debounce->state).
+*/
+INT16U DebounceSample(DEBOUNCE* debounce, INT16U sample)
+{
+	INT16U delta = sample ^ debounce->state;	// inputs disagreeing with the state
+	INT16U cnt0 = debounce->cnt0;
+	INT16U cnt1 = debounce->cnt1;
+	INT16U cnt2 = debounce->cnt2;
+	INT16U reached;
+
+	// increment where the input disagrees, back to zero where it agrees
+	cnt2 = (cnt2 ^ (cnt1 & cnt0)) & delta;
+	cnt1 = (cnt1 ^ cnt0) & delta;
+	cnt0 = ~cnt0 & delta;
+
+	// inputs whose counter equals 'samples'
+	reached = delta;
+	reached &= (debounce->samples & 1) ? cnt0 : ~cnt0;
+	reached &= (debounce->samples & 2) ? cnt1 : ~cnt1;
+	reached &= (debounce->samples & 4) ? cnt2 : ~cnt2;
+
+	debounce->state ^= reached;
+	debounce->cnt0 = cnt0 & ~reached;	// accepted : the counter starts over
+	debounce->cnt1 = cnt1 & ~reached;
+	debounce->cnt2 = cnt2 & ~reached;
+	return reached;
+}
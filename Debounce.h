@@ -0,0 +1,35 @@
+#ifndef _DEBOUNCE_H
+#define _DEBOUNCE_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define DEBOUNCE_MAX_SAMPLES	7		// Largest count held by the 3-bit vertical counters
+
+//! Debouncer of up to 16 inputs at once, one bit per input
+typedef struct _DEBOUNCE
+{
+	INT16U state;		/*!< Debounced image									*/
+	INT16U cnt0;		/*!< Vertical counters : bit n of cnt0..cnt2 is the		*/
+	INT16U cnt1;		/*!< number of samples input n has disagreed with		*/
+	INT16U cnt2;		/*!< 'state' in a row									*/
+	INT8U samples;		/*!< Samples in a row needed to accept a change (1-7)	*/
+} DEBOUNCE;
+
+//! Non zero while a change is being counted (an input disagrees with 'state')
+#define DebounceBusy(d)		((d)->cnt0 | (d)->cnt1 | (d)->cnt2)
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void DebounceInit(DEBOUNCE* debounce, INT16U state, INT8U samples);
+INT16U DebounceSample(DEBOUNCE* debounce, INT16U sample);
+
+#endif
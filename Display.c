@@ -0,0 +1,236 @@
+#include "Display.h"
+#include "Lcd.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+#define DISPLAY_NO_CURSOR	0xFF
+#define DISPLAY_SET_DDRAM	0x80	// HD44780 command : cursor to the address in the low bits
+
+//! Message held on a row, and the one waiting for it
+typedef struct _DISPLAY_REGION
+{
+	INT8U priority;						/*!< Priority of the message shown				*/
+	INT32U until;						/*!< OSTimeGet() at the end of its hold			*/
+	unsigned char waiting;				/*!< 1 if 'next' waits for the hold to end		*/
+	INT8U nextPriority;
+	char next[DISPLAY_COLS];			/*!< Latest message posted during the hold		*/
+} DISPLAY_REGION;
+
+static char displayFrame[DISPLAY_ROWS][DISPLAY_COLS];	// What the producers want shown
+static char displayShadow[DISPLAY_ROWS][DISPLAY_COLS];	// What the LCD shows
+static DISPLAY_REGION displayRegion[DISPLAY_ROWS];
+static unsigned char displayDirty = 0;					// displayFrame changed since the last render
+static OS_EVENT* displaySem;							// Posted when displayFrame gets dirty
+static INT8U displayCursor = DISPLAY_NO_CURSOR;			// DDRAM address of the LCD cursor
+
+// DDRAM address of the first cell of each row
+static const INT8U displayRowAddress[DISPLAY_ROWS] = {0x00, 0x40};
+static const INT16U displayHold[DISPLAY_PRIORITIES] = DISPLAY_HOLDS;
+
+INT32U displayUpdates = 0;
+INT32U displayRenders = 0;
+INT32U displayDeferred = 0;
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/****************** PRODUCERS *******************************/
+
+/*
+ * Must be called before the first DisplayText (the producers may start before
+ * the LCD task).
+*/
+void DisplayInit(void)
+{
+	INT8U row;
+	INT8U col;
+	for(row = 0; row < DISPLAY_ROWS; row++) {
+		for(col = 0; col < DISPLAY_COLS; col++) {
+			displayFrame[row][col] = ' ';
+			displayShadow[row][col] = ' ';
+		}
+		displayRegion[row].priority = DISPLAY_NORMAL;
+		displayRegion[row].until = 0;
+		displayRegion[row].waiting = 0;
+	}
+	displaySem = OSSemCreate(0);
+}
+
+/*
+ * Copies 'text' in 'width' cells, padded with spaces. Returns 1 if the LCD
+ * task must be woken up : the frame was clean, so it is not already going to
+ * render. To be called in a critical section.
+*/
+static unsigned char DisplayCopy(char* cell, char* text, INT8U width)
+{
+	unsigned char wake = !displayDirty;
+	for(; width; width--) {
+		*cell++ = *text ? *text++ : ' ';
+	}
+	displayDirty = 1;
+	displayUpdates++;
+	return wake;
+}
+
+/*
+ * Writes 'text' in the 'width' cells from (row, col), padded with spaces,
+ * whatever the message held on the row. Only the frame is written : the LCD
+ * task is woken up and renders the cells which changed. Updates made before
+ * it runs are rendered together, the latest text of each cell winning.
+ * Callable from the interrupts.
+*/
+void DisplayText(INT8U row, INT8U col, char* text, INT8U width)
+{
+	unsigned char wake;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	if(col + width > DISPLAY_COLS) {
+		width = DISPLAY_COLS - col;
+	}
+	OS_ENTER_CRITICAL();
+	wake = DisplayCopy(&displayFrame[row][col], text, width);
+	OS_EXIT_CRITICAL();
+	if(wake) {
+		OSSemPost(displaySem);
+	}
+}
+
+/*
+ * Shows a message on a whole row for at least the hold of its priority. A
+ * message less important than the one held waits for the end of the hold (an
+ * "Intrusion!" is never overwritten by a prompt before it could be read) ;
+ * only the latest of the waiting ones is kept. Callable from the interrupts.
+*/
+void DisplayPost(INT8U row, char* text, INT8U priority)
+{
+	DISPLAY_REGION* region = &displayRegion[row];
+	INT32U now = OSTimeGet();
+	unsigned char wake = 0;
+	INT8U col;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	OS_ENTER_CRITICAL();
+	if(priority < region->priority && (INT32S)(region->until - now) > 0) {
+		if(!region->waiting || priority >= region->nextPriority) {
+			wake = !region->waiting && !displayDirty;	// the LCD task times the end of the hold
+			for(col = 0; col < DISPLAY_COLS; col++) {
+				region->next[col] = *text ? *text++ : ' ';
+			}
+			region->nextPriority = priority;
+			region->waiting = 1;
+		}
+		displayDeferred++;
+	}
+	else {
+		wake = DisplayCopy(displayFrame[row], text, DISPLAY_COLS);
+		region->priority = priority;
+		region->until = now + displayHold[priority];
+		region->waiting = 0;	// superseded
+	}
+	OS_EXIT_CRITICAL();
+	if(wake) {
+		OSSemPost(displaySem);
+	}
+}
+
+/*
+ * A message of normal priority.
+*/
+void DisplayLine(INT8U row, char* text)
+{
+	DisplayPost(row, text, DISPLAY_NORMAL);
+}
+
+/****************** RENDERING *******************************/
+
+/*
+ * Sleeps until the frame changes or a waiting message can be shown (LCD task).
+*/
+void DisplayWait(void)
+{
+	INT8U err;
+	INT8U row;
+	INT16U timeout = 0;
+	INT32S left;
+	INT32U now = OSTimeGet();
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	OS_ENTER_CRITICAL();
+	for(row = 0; row < DISPLAY_ROWS; row++) {
+		if(displayRegion[row].waiting) {
+			left = (INT32S)(displayRegion[row].until - now);
+			if(left < 1) {
+				left = 1;
+			}
+			if(timeout == 0 || left < timeout) {
+				timeout = (INT16U)left;
+			}
+		}
+	}
+	OS_EXIT_CRITICAL();
+	OSSemPend(displaySem, timeout, &err);
+}
+
+/*
+ * Writes the cells of the frame which differ from the LCD, once the waiting
+ * messages whose hold ended are in the frame. However many updates were made
+ * since the last pass, they cost a single pass. The HD44780 moves its cursor
+ * to the next cell after each character, so the cursor is only set when the
+ * next cell to write is not the one following the last cell written : a
+ * single changed cell costs one character (plus the cursor if needed), and
+ * a row of changed cells one cursor command and the characters. The bytes are
+ * only queued : the LCD driver streams them while the task goes back to sleep.
+*/
+void DisplayRender(void)
+{
+	char frame[DISPLAY_ROWS][DISPLAY_COLS];
+	DISPLAY_REGION* region;
+	INT32U now = OSTimeGet();
+	INT8U row;
+	INT8U col;
+	INT8U address;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	OS_ENTER_CRITICAL();
+	for(row = 0; row < DISPLAY_ROWS; row++) {
+		region = &displayRegion[row];
+		if(region->waiting && (INT32S)(region->until - now) <= 0) {
+			DisplayCopy(displayFrame[row], region->next, DISPLAY_COLS);
+			region->priority = region->nextPriority;
+			region->until = now + displayHold[region->priority];
+			region->waiting = 0;
+		}
+		for(col = 0; col < DISPLAY_COLS; col++) {
+			frame[row][col] = displayFrame[row][col];
+		}
+	}
+	displayDirty = 0;	// later changes wake the task up again
+	displayRenders++;
+	OS_EXIT_CRITICAL();
+
+	for(row = 0; row < DISPLAY_ROWS; row++) {
+		for(col = 0; col < DISPLAY_COLS; col++) {
+			if(frame[row][col] == displayShadow[row][col]) {
+				continue;
+			}
+			address = displayRowAddress[row] + col;
+			if(address != displayCursor) {
+				LcdPut(LCD_CMD(DISPLAY_SET_DDRAM | address));
+			}
+			LcdPut(LCD_DATA(frame[row][col]));
+			displayShadow[row][col] = frame[row][col];
+			displayCursor = address + 1;
+		}
+	}
+}
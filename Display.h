@@ -0,0 +1,48 @@
+#ifndef _DISPLAY_H
+#define _DISPLAY_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define DISPLAY_ROWS		2
+#define DISPLAY_COLS		16
+
+// Regions of the screen
+#define DISPLAY_STATUS		0		// Row 0 : state of the system, messages
+#define DISPLAY_INPUT		1		// Row 1 : code being typed
+
+// Priorities of the messages : a message is kept on screen for the hold of its
+// priority, during which a less important one waits (see DisplayPost)
+#define DISPLAY_NORMAL		0		// Prompts, wrong code
+#define DISPLAY_HIGH		1		// Changes of state
+#define DISPLAY_ALERT		2		// Intrusions
+#define DISPLAY_PRIORITIES	3
+#define DISPLAY_HOLDS		{0, 1000, 3000}		// Hold (ticks) of each priority
+
+/********************************************************
+*						VARIABLES						*
+********************************************************/
+
+// Coalescing figures (read with uC/Probe or the debugger)
+extern INT32U displayUpdates;		// Changes of the frame
+extern INT32U displayRenders;		// Render passes : displayUpdates - displayRenders were saved
+extern INT32U displayDeferred;		// Messages which waited for a more important one
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void DisplayInit(void);
+void DisplayText(INT8U row, INT8U col, char* text, INT8U width);
+void DisplayPost(INT8U row, char* text, INT8U priority);
+void DisplayLine(INT8U row, char* text);
+void DisplayWait(void);
+void DisplayRender(void);
+
+#endif
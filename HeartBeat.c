@@ -0,0 +1,79 @@
+#include "HeartBeat.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+NODE_STATUS nodeStatus[NUMBER_NODES];
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/****************** ENCODE **********************************/
+
+void HeartBeatEncode(unsigned char* payload, unsigned int id, NODE_STATUS* status)
+{
+	payload[HB_BYTE_ID_LOW]			= id & 0xFF;
+	payload[HB_BYTE_ID_HIGH]		= id >> 8;
+	payload[HB_BYTE_STATE]			= status->state;
+	payload[HB_BYTE_CONFIG_GEN]		= status->configGeneration;
+	payload[HB_BYTE_PASSWORD_GEN]	= status->passwordGeneration;
+	payload[HB_BYTE_ERRORS]			= status->errors;
+	payload[HB_BYTE_EPOCH_LOW]		= status->epoch & 0xFF;
+	payload[HB_BYTE_EPOCH_HIGH]		= (status->epoch >> 8) & 0xFF;
+}
+
+/****************** DECODE **********************************/
+
+unsigned int HeartBeatDecode(unsigned char* payload, unsigned char dlc, NODE_STATUS* status)
+{
+	unsigned int id;
+
+	if(dlc == 0) {
+		return HB_INVALID_ID;
+	}
+	// Legacy heartbeat : only the node id is known
+	if(dlc < HB_DLC) {
+		return payload[HB_BYTE_ID_LOW];
+	}
+	id = payload[HB_BYTE_ID_LOW] | ((unsigned int)payload[HB_BYTE_ID_HIGH] << 8);
+	status->state				= payload[HB_BYTE_STATE];
+	status->configGeneration	= payload[HB_BYTE_CONFIG_GEN];
+	status->passwordGeneration	= payload[HB_BYTE_PASSWORD_GEN];
+	status->errors				= payload[HB_BYTE_ERRORS];
+	status->epoch				= payload[HB_BYTE_EPOCH_LOW] | ((unsigned int)payload[HB_BYTE_EPOCH_HIGH] << 8);
+	return id;
+}
+
+/****************** STORE ***********************************/
+
+unsigned int HeartBeatStore(unsigned char* payload, unsigned char dlc)
+{
+	NODE_STATUS status;
+	unsigned int id;
+
+	id = HeartBeatDecode(payload, dlc, &status);
+	if(id >= NUMBER_NODES) {
+		return HB_INVALID_ID;
+	}
+	if(dlc >= HB_DLC) {
+		nodeStatus[id] = status;
+	}
+	return id;
+}
+
+/****************** ERROR SUMMARY ***************************/
+
+unsigned char HeartBeatErrorSummary(unsigned char txErrors, unsigned char rxErrors)
+{
+	// One nibble per counter, 16 error counts per step (saturates at 240+)
+	return (txErrors & 0xF0) | (rxErrors >> 4);
+}
+
+/****************** GENERATIONS *****************************/
+
+unsigned char generationNewer(unsigned char a, unsigned char b)
+{
+	return (signed char)(a - b) > 0;
+}
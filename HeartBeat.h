@@ -0,0 +1,72 @@
+#ifndef _HEARTBEAT_H
+#define _HEARTBEAT_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include "Messages.h"
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+// Layout of the heartbeat payload (one byte per field, DLC 8)
+#define HB_DLC					8
+#define HB_BYTE_ID_LOW			0		// Node id, low byte (the only byte of the legacy DLC 1 heartbeat)
+#define HB_BYTE_ID_HIGH			1		// Node id, high byte
+#define HB_BYTE_STATE			2		// HB_STATE_xxx bits
+#define HB_BYTE_CONFIG_GEN		3		// Incremented on every arming/disarming
+#define HB_BYTE_PASSWORD_GEN	4		// Incremented on every password change
+#define HB_BYTE_ERRORS			5		// TX error summary (high nibble), RX error summary (low nibble)
+#define HB_BYTE_EPOCH_LOW		6		// Membership epoch, low byte
+#define HB_BYTE_EPOCH_HIGH		7		// Membership epoch, high byte
+
+// Bits of the HB_BYTE_STATE field
+#define HB_STATE_UNLOCKED		0x01	// System disarmed
+#define HB_STATE_TIMER			0x02	// Intrusion (entry) timer running
+#define HB_STATE_ALARM			0x04	// Buzzer on
+#define HB_STATE_PWD_CHANGE		0x08	// Password change procedure in progress
+#define HB_STATE_ERR_WARNING	0x10	// CAN error counters above the warning limit
+#define HB_STATE_ERR_PASSIVE	0x20	// CAN module in error passive state
+#define HB_STATE_BUS_OFF		0x40	// CAN module in bus off state
+#define HB_STATE_ALARM_MASK		(HB_STATE_UNLOCKED | HB_STATE_TIMER | HB_STATE_ALARM | HB_STATE_PWD_CHANGE)
+
+#define HB_INVALID_ID			0xFFFF
+
+/********************************************************
+*						VARIABLES						*
+********************************************************/
+
+//! Last status advertised by a node in its heartbeat
+typedef struct _NODE_STATUS
+{
+	unsigned char state;				/*!< HB_STATE_xxx bits					*/
+	unsigned char configGeneration;		/*!< Arming/disarming generation		*/
+	unsigned char passwordGeneration;	/*!< Password generation				*/
+	unsigned char errors;				/*!< TX/RX error summary				*/
+	unsigned int epoch;					/*!< Epoch of its membership view		*/
+} NODE_STATUS;
+
+//! Status table, indexed by node id
+extern NODE_STATUS nodeStatus[NUMBER_NODES];
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+//! Fills the 8 bytes of a heartbeat payload
+void HeartBeatEncode(unsigned char* payload, unsigned int id, NODE_STATUS* status);
+
+//! Decodes a received heartbeat, returns the sender id (HB_INVALID_ID if unusable)
+unsigned int HeartBeatDecode(unsigned char* payload, unsigned char dlc, NODE_STATUS* status);
+
+//! Stores a received heartbeat in the status table, returns the sender id (HB_INVALID_ID if unusable)
+unsigned int HeartBeatStore(unsigned char* payload, unsigned char dlc);
+
+//! Compresses the transmit/receive error counters into one byte
+unsigned char HeartBeatErrorSummary(unsigned char txErrors, unsigned char rxErrors);
+
+//! Returns 1 if generation 'a' is more recent than generation 'b' (wrap-around safe)
+unsigned char generationNewer(unsigned char a, unsigned char b);
+
+#endif
@@ -1,59 +1,139 @@
 #include <includes.h>
+#include <libpic30.h>	// __delay32
+#include "Keyboard.h"
+#include "Debounce.h"
 
-void KeyboardInit(void)
+static OS_EVENT* keyQueue;						// Where the events are posted (KEY_EVENT*)
+static INT16U keyEvents[KEY_EVENT_POOL][MSG_BLOCK_WORDS(KEY_EVENT)];
+MSG_POOL keyEventPool;
+static unsigned char keyboardActive = 0;		// 1 while a key is held : the matrix is scanned
+static unsigned char scanCountdown;
+static DEBOUNCE keyDebounce;					// One bit per key of the matrix image
+static INT8U repeatKey = KEYBOARD_NO_KEY;		// Last key pressed, repeated while held
+static INT16S repeatCountdown;					// Ticks before its next repeat
+
+// Key code of each bit of the matrix image (bit = 4 * column + row)
+static const INT8U keyOfBit[16] = {	1, 4, 7, 10,
+									2, 5, 8, 0,
+									3, 6, 9, 11,
+									15, 14, 13, 12	};
+
+/*
+ * The events are posted to 'queue', which must be able to hold the whole pool
+ * (KEY_EVENT_POOL) so that a posted event is never dropped.
+*/
+void KeyboardInit(OS_EVENT* queue)
 {
+	keyQueue = queue;
+	MsgPoolCreate(&keyEventPool, keyEvents, KEY_EVENT_POOL, sizeof(keyEvents[0]), (INT8U *)"Key events");
+	DebounceInit(&keyDebounce, 0, KEYBOARD_DEBOUNCE_SAMPLES);
 	TRISD &= 0xF0FF;//colonnes du clavier en output
+	LATD |= KEYBOARD_COLUMNS;//toutes actives au repos : une touche enfoncee leve sa ligne
 	//lignes du clavier en input
 	AD1PCFGL |= 0x0F00;
 	AD2PCFGL |= 0x0F00;
 	TRISB |=0x0F00;
 }
 
-INT8U KeyboardScan( void )
+/*
+ * Reads the whole matrix into a 16-bit image, one bit per key (set when
+ * pressed) : every key held at the same time is seen.
+*/
+INT16U KeyboardScan( void )
+{
+	INT16U image = 0;
+	unsigned char column;
+
+	for(column = 0; column < 4; column++) {
+		LATD = (LATD & 0xF0FF) | (0x0100 << column);
+		__delay32(KEYBOARD_SETTLE_CYCLES);
+		image |= ((PORTB & KEYBOARD_ROWS) >> 8) << (column * 4);
+	}
+	LATD |= KEYBOARD_COLUMNS;//retour au repos
+	return image;
+}
+
+/*
+ * Posts an event stamped with the cycle counter. Each event is a message of
+ * its own : nothing is shared with the consumer, which frees it once handled.
+*/
+static void KeyboardPost(INT8U key, INT8U type)
+{
+	KEY_EVENT* event = (KEY_EVENT*)MsgAlloc(&keyEventPool);
+	if(event == (KEY_EVENT*)0) {
+		return;
+	}
+	event->time = BSP_CycleTmrRd();
+	event->key = key;
+	event->type = type;
+	MsgPost(keyQueue, event);
+}
+
+/*
+ * Called every tick by App_TimeTickHook : polls the keypad every tick while it
+ * is idle, every KEYBOARD_SCAN_TICKS while a key is held.
+*/
+void KeyboardTickHook(void)
+{
+	if(keyboardActive && scanCountdown) {
+		scanCountdown--;
+		return;
+	}
+	scanCountdown = KEYBOARD_SCAN_TICKS - 1;
+	KeyboardPoll();
+}
+
+/*
+ * RB8-RB11 have no change notification on this dsPIC, so while the keyboard is
+ * idle polling stands for it : with every column parked active, a single read
+ * of the rows tells whether a key went down. Only then is the matrix scanned,
+ * at each poll, until every key is released. All the keys are debounced at
+ * once by the vertical counters of keyDebounce : a press or a release is
+ * reported once the key kept its level for KEYBOARD_DEBOUNCE_SAMPLES scans.
+ * The last key pressed repeats while held, after KEYBOARD_REPEAT_DELAY then
+ * every KEYBOARD_REPEAT_PERIOD. To be called every KEYBOARD_SCAN_TICKS : by
+ * the tick hook, or as a step of the frame in the cyclic executive mode.
+*/
+void KeyboardPoll(void)
 {
-	INT8U res;
-	INT8U tmp;
-	
-	res = 255;
-	//colonne 1
-	LATD = (LATD & 0xF0FF)| 0x0100;
-	//OSTimeDly (1);					//mise en sommeil pendant 1 coup d'horloge
-	for (tmp=0;tmp<255;tmp++);
-	switch(PORTB & 0x0F00){
-		case 0x0100 : res = 1; break;
-		case 0x0200 : res = 4; break;
-		case 0x0400 : res = 7; break;
-		case 0x0800 : res = 10; break;
+	INT16U changed;
+	INT16U bit;
+	unsigned char i;
+
+	if(!keyboardActive) {
+		if(!(PORTB & KEYBOARD_ROWS)) {
+			return;
+		}
+		keyboardActive = 1;
 	}
-	//colonne 2
-	LATD = (LATD & 0xF0FF)| 0x0200;
-	//OSTimeDly (1);					//mise en sommeil pendant 1 coup d'horloge
-	for (tmp=0;tmp<255;tmp++);
-	switch(PORTB & 0x0F00){
-		case 0x0100 : res = 2; break;
-		case 0x0200 : res = 5; break;
-		case 0x0400 : res = 8; break;
-		case 0x0800 : res = 0; break;
+	changed = DebounceSample(&keyDebounce, KeyboardScan());
+	for(i = 0, bit = 1; changed; i++, bit <<= 1) {
+		if(!(changed & bit)) {
+			continue;
+		}
+		changed &= ~bit;
+		if(keyDebounce.state & bit) {
+			KeyboardPost(keyOfBit[i], KEY_PRESS);
+			repeatKey = keyOfBit[i];
+			repeatCountdown = KEYBOARD_REPEAT_DELAY;
+		}
+		else {
+			KeyboardPost(keyOfBit[i], KEY_RELEASE);
+			if(repeatKey == keyOfBit[i]) {
+				repeatKey = KEYBOARD_NO_KEY;
+			}
+		}
 	}
-	//colonne 3
-	LATD = (LATD & 0xF0FF)| 0x0400;
-	//OSTimeDly (1);					//mise en sommeil pendant 1 coup d'horloge
-	for (tmp=0;tmp<255;tmp++);
-	switch(PORTB & 0x0F00){
-		case 0x0100 : res = 3; break;
-		case 0x0200 : res = 6; break;
-		case 0x0400 : res = 9; break;
-		case 0x0800 : res = 11; break;
+	#if KEYBOARD_REPEAT_DELAY > 0
+	if(repeatKey != KEYBOARD_NO_KEY) {
+		repeatCountdown -= KEYBOARD_SCAN_TICKS;
+		if(repeatCountdown <= 0) {
+			KeyboardPost(repeatKey, KEY_REPEAT);
+			repeatCountdown += KEYBOARD_REPEAT_PERIOD;
+		}
 	}
-	//colonne 4
-	LATD = (LATD & 0xF0FF)| 0x0800;
-	//OSTimeDly (1);					//mise en sommeil pendant 1 coup d'horloge
-	for (tmp=0;tmp<255;tmp++);
-	switch(PORTB & 0x0F00){
-		case 0x0100 : res = 15; break;
-		case 0x0200 : res = 14; break;
-		case 0x0400 : res = 13; break;
-		case 0x0800 : res = 12; break;
+	#endif
+	if(!keyDebounce.state && !DebounceBusy(&keyDebounce)) {
+		keyboardActive = 0;	// released : back to watching the rows
 	}
-	return res;
 }
@@ -1,2 +1,34 @@
-void KeyboardInit(void);
-INT8U KeyboardScan( void );
+#include "Msg.h"
+
+#define KEYBOARD_COLUMNS		0x0F00		// RD8-RD11, driven high one at a time (all of them while idle)
+#define KEYBOARD_ROWS			0x0F00		// RB8-RB11, high when a key of the driven column is pressed
+#if APP_CYCLIC_EXEC_EN > 0
+#define KEYBOARD_SCAN_TICKS		APP_CYCLIC_FRAME_TICKS	// Scanned once per frame (see FrameTask)
+#else
+#define KEYBOARD_SCAN_TICKS		2			// Scan period (ticks) while a key is held
+#endif
+#define KEYBOARD_DEBOUNCE_SAMPLES	4		// Scans a key must agree before a press or release (1-7)
+#define KEYBOARD_REPEAT_DELAY	500			// Ticks a key is held before it repeats (0 : no repeat)
+#define KEYBOARD_REPEAT_PERIOD	150			// Ticks between two repeats
+#define KEYBOARD_SETTLE_CYCLES	80			// Time (cycles, 2us) for the rows to follow a column
+#define KEYBOARD_NO_KEY			255
+#define KEY_EVENT_POOL			16			// Events which can wait for the consumer (type-ahead)
+
+#define KEY_RELEASE				0
+#define KEY_PRESS				1
+#define KEY_REPEAT				2
+
+//! One keypad event : a message of keyEventPool, freed by the consumer (MsgFree)
+typedef struct _KEY_EVENT
+{
+	INT32U time;		/*!< BSP_CycleTmrRd() when the event was detected	*/
+	INT8U key;			/*!< Key code (0-15)							*/
+	INT8U type;			/*!< KEY_PRESS, KEY_RELEASE or KEY_REPEAT		*/
+} KEY_EVENT;
+
+extern MSG_POOL keyEventPool;	// Its exhausted and lost counters are the events dropped
+
+void KeyboardInit(OS_EVENT* queue);
+INT16U KeyboardScan( void );
+void KeyboardTickHook(void);
+void KeyboardPoll(void);
@@ -0,0 +1,99 @@
+#include <libpic30.h>	// __delay32
+#include "Lcd.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+#define LCD_E			(1 << 4)	// RD4
+#define LCD_RS			(1 << 15)	// RB15
+#define LCD_E_CYCLES	12			// Width of the E strobe (> 230ns)
+
+static INT16U lcdQueue[LCD_QUEUE_SIZE];
+static volatile INT8U lcdHead = 0;				// Next entry written (LCD task)
+static volatile INT8U lcdTail = 0;				// Next entry sent (Timer 1 interrupt)
+static INT8U lcdHold = 0;						// Periods before the next entry (long commands)
+#if APP_LCD_BENCH_EN > 0
+INT32U lcdIsrCycles = 0;
+INT32U lcdIsrBytes = 0;
+#endif
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * Takes the LCD over once uC/LCD initialised it (DispInit) : from then on, the
+ * bytes are streamed by the Timer 1 interrupt, one per LCD_PERIOD_US, while
+ * the LCD task goes on. The timer only runs while the queue holds something.
+*/
+void LcdInit(void)
+{
+	T1CON = 0;				// Fcy, prescaler = 1, stopped
+	TMR1 = 0;
+	PR1 = (INT16U)(BSP_CPU_ClkFrq() / 1000000L * LCD_PERIOD_US) - 1;
+	IPC0bits.T1IP = TIMER_INT_PRIO;
+	IFS0bits.T1IF = 0;
+	IEC0bits.T1IE = 1;
+}
+
+/*
+ * Queues a command (LCD_CMD) or a character (LCD_DATA) and returns at once.
+ * Only the LCD task writes the queue ; should it be full, the task sleeps a
+ * tick, the interrupt emptying it meanwhile.
+*/
+void LcdPut(INT16U entry)
+{
+	INT8U next = (lcdHead + 1) % LCD_QUEUE_SIZE;
+	while(next == lcdTail) {
+		OSTimeDly(1);
+	}
+	lcdQueue[lcdHead] = entry;
+	lcdHead = next;
+	T1CON |= TON;
+}
+
+/*
+ * Sends one entry per period : data lines and RS, then a strobe of E. The
+ * HD44780 has executed it by the next period, so neither the busy flag nor a
+ * delay of the task is needed. The clear and home commands hold the queue
+ * for LCD_LONG_PERIODS. The timer is stopped once the queue is empty. The
+ * dsPIC33FJ256GP710 has no Parallel Master Port : the strobe is driven here.
+*/
+void __attribute__((interrupt, no_auto_psv))_T1Interrupt(void)
+{
+	INT16U entry;
+#if APP_LCD_BENCH_EN > 0
+	INT16U start = TMR3;
+#endif
+
+	IFS0bits.T1IF = 0;
+	if(lcdHold) {
+		lcdHold--;
+		return;
+	}
+	if(lcdTail == lcdHead) {
+		T1CON &= ~TON;
+		return;
+	}
+	entry = lcdQueue[lcdTail];
+	lcdTail = (lcdTail + 1) % LCD_QUEUE_SIZE;
+
+	if(entry & LCD_RS_DATA) {
+		LATB |= LCD_RS;
+	}
+	else {
+		LATB &= ~LCD_RS;
+		if((INT8U)entry <= 0x03) {
+			lcdHold = LCD_LONG_PERIODS;	// clear display, return home
+		}
+	}
+	LATE = (LATE & 0xFF00) | (INT8U)entry;
+	LATD |= LCD_E;
+	__delay32(LCD_E_CYCLES);
+	LATD &= ~LCD_E;
+#if APP_LCD_BENCH_EN > 0
+	lcdIsrCycles += (INT16U)(TMR3 - start);
+	lcdIsrBytes++;
+#endif
+}
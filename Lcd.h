@@ -0,0 +1,34 @@
+#ifndef _LCD_H
+#define _LCD_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define LCD_QUEUE_SIZE			64			// Bytes waiting for the LCD (a whole frame fits)
+#define LCD_PERIOD_US			50			// One byte per period : 37us typical for the HD44780, up to ~50us on slow modules
+#define LCD_LONG_PERIODS		((1640 + LCD_PERIOD_US - 1) / LCD_PERIOD_US)	// Periods taken by the clear and home commands (1.64ms)
+
+// Queue entries : the byte, and RS in bit 8
+#define LCD_RS_DATA				0x0100
+#define LCD_CMD(c)				((INT16U)(INT8U)(c))
+#define LCD_DATA(d)				(LCD_RS_DATA | (INT8U)(d))
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void LcdInit(void);
+void LcdPut(INT16U entry);
+
+#if APP_LCD_BENCH_EN > 0
+extern INT32U lcdIsrCycles;		// Cycles spent in the Timer 1 interrupt (see lcdBench)
+extern INT32U lcdIsrBytes;		// Bytes it sent
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+#include "Lock.h"
+#include "Trace.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+LOCK_STATS lockStats[LOCKS];
+static INT8U locks = 0;
+
+static LOCK_STATS* LockFind(OS_EVENT* mutex);
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * Creates a mutex whose inheritance priority is 'pip' and profiles it, under
+ * 'name', as long as LOCKS are not all used.
+*/
+OS_EVENT* LockCreate(INT8U pip, char* name)
+{
+	INT8U err;
+	INT8U i;
+	LOCK_STATS* stats;
+	OS_EVENT* mutex = OSMutexCreate(pip, &err);
+
+	if(mutex == (OS_EVENT*)0 || locks >= LOCKS) {
+		return mutex;
+	}
+	stats = &lockStats[locks++];
+	stats->mutex = mutex;
+	stats->pip = pip;
+	stats->owner = LOCK_FREE;
+	for(i = 0; i < LOCK_NAME_SIZE - 1 && name[i]; i++) {
+		stats->name[i] = name[i];
+	}
+	stats->name[i] = 0;
+	return mutex;
+}
+
+static LOCK_STATS* LockFind(OS_EVENT* mutex)
+{
+	INT8U i;
+	for(i = 0; i < locks; i++) {
+		if(lockStats[i].mutex == mutex) {
+			return &lockStats[i];
+		}
+	}
+	return (LOCK_STATS*)0;
+}
+
+/*
+ * Takes the mutex. When another task holds it, the caller waits : the wait is
+ * timed, and if the holder runs at a lower priority than both the caller and
+ * the PIP, uC/OS-II raises it to the PIP (a priority inheritance boost).
+*/
+void LockPend(OS_EVENT* mutex)
+{
+	INT8U err;
+	INT8U holder;
+	INT8U contended = 0;
+	INT32U start;
+	INT32U wait;
+	LOCK_STATS* stats = LockFind(mutex);
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	TRACE_EVENT_ADD(TRACE_MUTEX_PEND, mutex, OSTCBCur->OSTCBPrio);
+	if(stats == (LOCK_STATS*)0) {
+		OSMutexPend(mutex, 0, &err);
+		TRACE_EVENT_ADD(TRACE_MUTEX_TAKEN, mutex, OSTCBCur->OSTCBPrio);
+		return;
+	}
+	OS_ENTER_CRITICAL();
+	stats->pends++;
+	if((mutex->OSEventCnt & OS_MUTEX_KEEP_LOWER_8) != OS_MUTEX_AVAILABLE) {
+		contended = 1;
+		stats->contended++;
+		holder = ((OS_TCB*)mutex->OSEventPtr)->OSTCBPrio;
+		if(holder > stats->pip && holder > OSTCBCur->OSTCBPrio) {
+			stats->boosts++;
+		}
+	}
+	OS_EXIT_CRITICAL();
+	start = BSP_CycleTmrRd();
+	OSMutexPend(mutex, 0, &err);
+	TRACE_EVENT_ADD(TRACE_MUTEX_TAKEN, mutex, OSTCBCur->OSTCBPrio);
+	stats->takenAt = BSP_CycleTmrRd();
+	stats->owner = OSTCBCur->OSTCBPrio;
+	if(contended) {
+		wait = stats->takenAt - start;
+		OS_ENTER_CRITICAL();
+		stats->waitCycles += wait;
+		if(wait > stats->waitMax) {
+			stats->waitMax = wait;
+		}
+		OS_EXIT_CRITICAL();
+	}
+}
+
+/*
+ * Releases the mutex, the hold being timed from LockPend.
+*/
+void LockPost(OS_EVENT* mutex)
+{
+	INT32U hold;
+	LOCK_STATS* stats = LockFind(mutex);
+
+	TRACE_EVENT_ADD(TRACE_MUTEX_POST, mutex, OSTCBCur->OSTCBPrio);
+	if(stats != (LOCK_STATS*)0) {
+		hold = BSP_CycleTmrRd() - stats->takenAt;	// only the holder writes these
+		stats->holdCycles += hold;
+		if(hold > stats->holdMax) {
+			stats->holdMax = hold;
+		}
+		stats->owner = LOCK_FREE;
+	}
+	OSMutexPost(mutex);
+}
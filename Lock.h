@@ -0,0 +1,45 @@
+#ifndef _LOCK_H
+#define _LOCK_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define LOCKS				6			// Mutexes which can be profiled
+#define LOCK_NAME_SIZE		10
+#define LOCK_FREE			0xFF		// 'owner' of a mutex nobody holds
+
+//! Contention of one mutex, in cycles (BSP_CycleTmrRd). Dumped as is for
+//! tools/lockreport.c : keep the layout in step with it.
+typedef struct _LOCK_STATS
+{
+	INT32U pends;					/*!< Times the mutex was taken						*/
+	INT32U contended;				/*!< Of them, times it was held by another task		*/
+	INT32U boosts;					/*!< Of them, times the holder inherited the PIP	*/
+	INT32U waitCycles;				/*!< Time spent waiting for it (wraps)				*/
+	INT32U waitMax;
+	INT32U holdCycles;				/*!< Time it was held (wraps)						*/
+	INT32U holdMax;
+	INT32U takenAt;					/*!< BSP_CycleTmrRd() when the holder took it		*/
+	INT8U pip;						/*!< Priority inheritance priority					*/
+	INT8U owner;					/*!< Priority of the holder (LOCK_FREE : none)		*/
+	char name[LOCK_NAME_SIZE];
+	OS_EVENT* mutex;
+} LOCK_STATS;
+
+extern LOCK_STATS lockStats[LOCKS];		// Read with uC/Probe or the debugger
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+OS_EVENT* LockCreate(INT8U pip, char* name);
+void LockPend(OS_EVENT* mutex);
+void LockPost(OS_EVENT* mutex);
+
+#endif
@@ -0,0 +1,164 @@
+#include "Membership.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+unsigned char members[NUMBER_NODES];
+unsigned char memberCounter[NUMBER_NODES];
+unsigned int membershipEpoch = 0;
+
+static unsigned int self = MEMBER_NONE;
+static unsigned char epochKnown = 0;		// 0 until we heard from the group
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/****************** EPOCHS **********************************/
+
+unsigned char epochNewer(unsigned int a, unsigned int b)
+{
+	return (short)(a - b) > 0;
+}
+
+static unsigned int epochNext(unsigned int epoch)
+{
+	return (epoch + 1) & 0xFFFF;
+}
+
+/****************** INITIALIZE ******************************/
+
+void MembershipInit(unsigned int id)
+{
+	self = id;
+	if(self < NUMBER_NODES) {
+		members[self] = 1;
+		memberCounter[self] = 0;
+	}
+}
+
+/****************** EVENTS **********************************/
+
+/*
+ * Adds or removes 'id', returns 1 if the view changed. Eviction and leave are
+ * handled the same way, only the reaction of the application differs.
+*/
+static unsigned char MembershipChange(MEMBER_EVENT event, unsigned int id)
+{
+	if(id >= NUMBER_NODES) {
+		return 0;
+	}
+	if(event == MEMBER_JOIN) {
+		memberCounter[id] = 0;
+		if(members[id]) {
+			return 0;
+		}
+		members[id] = 1;
+		return 1;
+	}
+	if(!members[id]) {
+		return 0;
+	}
+	members[id] = 0;
+	return 1;
+}
+
+unsigned int MembershipLocalEvent(MEMBER_EVENT event, unsigned int id)
+{
+	MembershipChange(event, id);
+	membershipEpoch = epochNext(membershipEpoch);
+	return membershipEpoch;
+}
+
+/*
+ * Every node applies the events in the order of the bus, with the epoch
+ * becoming the largest of its own successor and the one of the event. Events
+ * which do not change the view (e.g. two nodes evicting the same member) do
+ * not increment it, so that all the nodes end up with the same epoch.
+*/
+unsigned char MembershipApply(MEMBER_EVENT event, unsigned int id, unsigned int epoch)
+{
+	unsigned int next;
+
+	if(id == self) {
+		// Another node evicted us while we are alive : we stay in our own view and the caller announces us again
+		return 0;
+	}
+	if(!MembershipChange(event, id)) {
+		if(epochNewer(epoch, membershipEpoch)) {
+			membershipEpoch = epoch;
+		}
+		epochKnown = 1;
+		return 0;
+	}
+	next = epochNext(membershipEpoch);
+	membershipEpoch = epochNewer(epoch, next) ? epoch : next;
+	epochKnown = 1;
+	return 1;
+}
+
+/****************** HEARTBEATS ******************************/
+
+/*
+ * A heartbeat carrying our epoch comes from a member of the same view. If the
+ * sender knows a more recent epoch, we missed events : the view is rebuilt
+ * from the heartbeats of that epoch and the caller announces us again.
+*/
+unsigned char MembershipHeard(unsigned int id, unsigned int epoch)
+{
+	unsigned int i;
+	unsigned char rebuilt = 0;
+
+	if(id >= NUMBER_NODES || id == self) {
+		return 0;
+	}
+	if(!epochKnown || epochNewer(epoch, membershipEpoch)) {
+		for(i = 0; i < NUMBER_NODES; i++) {
+			members[i] = (i == self);
+			memberCounter[i] = 0;
+		}
+		rebuilt = epochKnown;
+		membershipEpoch = epoch;
+		epochKnown = 1;
+	}
+	if(epoch == membershipEpoch) {
+		members[id] = 1;
+	}
+	memberCounter[id] = 0;
+	return rebuilt;
+}
+
+/****************** TIMEOUTS ********************************/
+
+void MembershipTick(void)
+{
+	unsigned int i;
+
+	for(i = 0; i < NUMBER_NODES; i++) {
+		if(members[i] && i != self && memberCounter[i] <= MEMBER_TIMEOUT_CHECKS) {
+			memberCounter[i]++;
+		}
+	}
+}
+
+unsigned int MembershipExpired(unsigned int from)
+{
+	unsigned int i;
+
+	for(i = from; i < NUMBER_NODES; i++) {
+		if(members[i] && i != self && memberCounter[i] > MEMBER_TIMEOUT_CHECKS) {
+			return i;
+		}
+	}
+	return MEMBER_NONE;
+}
+
+void MembershipRestartTimeouts(void)
+{
+	unsigned int i;
+
+	for(i = 0; i < NUMBER_NODES; i++) {
+		memberCounter[i] = 0;
+	}
+}
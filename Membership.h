@@ -0,0 +1,68 @@
+#ifndef _MEMBERSHIP_H
+#define _MEMBERSHIP_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include "Messages.h"
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define MEMBER_TIMEOUT_CHECKS	50		// A member is evicted after more checks (100ms) than this without heartbeat
+#define MEMBER_NONE				0xFFFF
+
+// Layout of the memberJoin/memberLeave/memberEvict payload : node id (low, high), epoch (low, high)
+#define MEMBER_EVENT_DLC		4
+
+//! Membership events
+typedef enum _MEMBER_EVENT
+{
+	MEMBER_JOIN		= 0,		/*!< A node enters the group (start-up, rejoin)		*/
+	MEMBER_LEAVE	= 1,		/*!< A node leaves the group on purpose (maintenance)	*/
+	MEMBER_EVICT	= 2			/*!< A member stopped sending heartbeats				*/
+} MEMBER_EVENT;
+
+/********************************************************
+*						VARIABLES						*
+********************************************************/
+
+//! 1 for each node of the current view, indexed by node id
+extern unsigned char members[NUMBER_NODES];
+
+//! Checks elapsed since the last heartbeat of each member
+extern unsigned char memberCounter[NUMBER_NODES];
+
+//! Version of the view, incremented by every change (wraps around)
+extern unsigned int membershipEpoch;
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+//! Adds this node, once it has an id, to the view built from the heartbeats heard so far
+void MembershipInit(unsigned int self);
+
+//! Applies an event of this node, returns the epoch to send with it
+unsigned int MembershipLocalEvent(MEMBER_EVENT event, unsigned int id);
+
+//! Applies an event received from another node, returns 1 if the view changed
+unsigned char MembershipApply(MEMBER_EVENT event, unsigned int id, unsigned int epoch);
+
+//! Records a heartbeat, returns 1 if the view was rebuilt from a more recent epoch (we must announce ourselves)
+unsigned char MembershipHeard(unsigned int id, unsigned int epoch);
+
+//! One check period elapsed : ages the counters of the members
+void MembershipTick(void);
+
+//! Returns the first member from 'from' on whose heartbeat is overdue (MEMBER_NONE if none)
+unsigned int MembershipExpired(unsigned int from);
+
+//! Restarts the timeout of every member
+void MembershipRestartTimeouts(void);
+
+//! Returns 1 if epoch 'a' is more recent than epoch 'b' (wrap-around safe)
+unsigned char epochNewer(unsigned int a, unsigned int b);
+
+#endif
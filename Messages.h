@@ -0,0 +1,44 @@
+#ifndef _MESSAGES_H
+#define _MESSAGES_H
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define OFFSET       0x200	// Offset to identify our node in the CAN
+#ifndef NUMBER_NODES
+#define NUMBER_NODES 10 	// Upper bound (maximum 10 nodes 0-9), may be set at build time (e.g. bench/)
+#endif
+
+/********************************************************
+*						VARIABLES						*
+********************************************************/
+
+//! Identifiers of the messages exchanged between the nodes
+typedef enum MessageTypes {
+    heartbeat = OFFSET+0,
+    intrusion = OFFSET+1,		// node id, zones tripped (bit n : DIOn+1), analog inputs tripped
+    disarming = OFFSET+2,
+    arming = OFFSET+4,
+    alarmStarted = OFFSET+8,
+    idClaim = OFFSET+16,
+    newPassword = OFFSET+24,
+    idAck = OFFSET+32,
+    memberJoin = OFFSET+40,
+    memberLeave = OFFSET+48,
+    memberEvict = OFFSET+56
+} MessageTypes;
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+//! Loads the transmit buffer with the message and sends it
+void send(MessageTypes messageid, unsigned char size, unsigned char* message);
+
+//! Same as send() but with an extended identifier (the 18 bits of 'eid' extend 'messageid')
+void sendExtended(MessageTypes messageid, unsigned long eid, unsigned char size, unsigned char* message);
+
+//! Same as send() but through the reply buffer, to be used from the CAN reception task only
+void reply(MessageTypes messageid, unsigned char size, unsigned char* message);
+
+#endif
@@ -0,0 +1,90 @@
+#include "Msg.h"
+#include "Trace.h"
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * 'storage' holds 'blocks' blocks of 'blockSize' bytes, each one a header and
+ * a message (see MSG_BLOCK_WORDS).
+*/
+void MsgPoolCreate(MSG_POOL* pool, void* storage, INT16U blocks, INT16U blockSize, INT8U* name)
+{
+	INT8U err;
+	pool->mem = OSMemCreate(storage, blocks, blockSize, &err);
+	OSMemNameSet(pool->mem, name, &err);
+	pool->blocks = blocks;
+	pool->used = 0;
+	pool->highWater = 0;
+	pool->exhausted = 0;
+	pool->lost = 0;
+}
+
+/*
+ * Returns a message owned by the caller, or 0 if the pool is empty (the
+ * caller drops what it wanted to send : the pool is the backpressure).
+ * Callable from the interrupts.
+*/
+void* MsgAlloc(MSG_POOL* pool)
+{
+	INT8U err;
+	MSG_HEADER* header;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	header = (MSG_HEADER*)OSMemGet(pool->mem, &err);
+	OS_ENTER_CRITICAL();
+	if(header == (MSG_HEADER*)0) {
+		pool->exhausted++;
+		OS_EXIT_CRITICAL();
+		return (void*)0;
+	}
+	if(++pool->used > pool->highWater) {
+		pool->highWater = pool->used;
+	}
+	OS_EXIT_CRITICAL();
+	header->pool = pool;
+	return header + 1;
+}
+
+/*
+ * Gives the message to the receiver pending on 'queue' : the sender must not
+ * touch it any more, the receiver frees it once consumed. If the queue is
+ * full, the message is freed here. Callable from the interrupts.
+*/
+INT8U MsgPost(OS_EVENT* queue, void* msg)
+{
+	MSG_HEADER* header = (MSG_HEADER*)msg - 1;
+	INT8U err = OSQPost(queue, msg);
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	TRACE_EVENT_ADD(TRACE_Q_POST, queue, msg);
+	if(err != OS_ERR_NONE) {
+		OS_ENTER_CRITICAL();
+		header->pool->lost++;
+		OS_EXIT_CRITICAL();
+		MsgFree(msg);
+	}
+	return err;
+}
+
+/*
+ * Gives a consumed message back to its pool. Callable from the interrupts.
+*/
+void MsgFree(void* msg)
+{
+	MSG_HEADER* header = (MSG_HEADER*)msg - 1;
+	MSG_POOL* pool = header->pool;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	OSMemPut(pool->mem, header);
+	OS_ENTER_CRITICAL();
+	pool->used--;
+	OS_EXIT_CRITICAL();
+}
@@ -0,0 +1,42 @@
+#ifndef _MSG_H
+#define _MSG_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+//! Pool of fixed-size message blocks (one uC/OS-II memory partition)
+typedef struct _MSG_POOL
+{
+	OS_MEM* mem;
+	INT16U blocks;			/*!< Blocks of the pool									*/
+	INT16U used;			/*!< Blocks owned by a sender or a receiver				*/
+	INT16U highWater;		/*!< Most blocks ever used at once						*/
+	INT32U exhausted;		/*!< Allocations refused : the pool was empty			*/
+	INT32U lost;			/*!< Messages freed because the queue was full			*/
+} MSG_POOL;
+
+//! Put before each message : the pool it goes back to
+typedef struct _MSG_HEADER
+{
+	MSG_POOL* pool;
+} MSG_HEADER;
+
+//! Words of a block holding a message of type 'type' (storage : INT16U name[blocks][MSG_BLOCK_WORDS(type)])
+#define MSG_BLOCK_WORDS(type)	((sizeof(MSG_HEADER) + sizeof(type) + 1) / 2)
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void MsgPoolCreate(MSG_POOL* pool, void* storage, INT16U blocks, INT16U blockSize, INT8U* name);
+void* MsgAlloc(MSG_POOL* pool);
+INT8U MsgPost(OS_EVENT* queue, void* msg);
+void MsgFree(void* msg);
+
+#endif
@@ -0,0 +1,236 @@
+#include <includes.h>
+#include "NodeId.h"
+#include "Membership.h"
+#include "Display.h"
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+// Outcome of the claim in progress
+#define CLAIM_PENDING			0
+#define CLAIM_LOST				1
+#define CLAIM_ACKED				2
+
+#define ID_CLAIM_FULL_RETRY_TICKS	5000	// Delay before retrying when every id is taken (one heartbeat period)
+#define ID_CLAIM_FULL_JITTER_TICKS	1000	// Random part of that delay, so that the waiting nodes do not retry together
+#define ID_NONE					0xFF
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+static OS_EVENT* idClaimSem;					// Posted by the CAN reception task once the claim in progress is decided
+static volatile unsigned char owned = 0;		// 1 once 'candidate' is our id
+static volatile unsigned char candidate = ID_NONE;
+static volatile unsigned long nonce;
+static volatile unsigned char result;
+static volatile unsigned char taken[NUMBER_NODES];	// Ids claimed by other nodes
+static volatile unsigned int seed = 0xACE1;
+
+// Last claim granted by this node, so that only one claimer per id gets a grant
+static unsigned char grantedId = ID_NONE;
+static unsigned long grantedNonce;
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/****************** NONCES **********************************/
+
+static unsigned int NodeIdRandom(void)
+{
+	unsigned int x = seed;
+
+	if(x == 0) {
+		x = 0xACE1;
+	}
+	// xorshift, period 2^16-1
+	x ^= x << 7;
+	x ^= x >> 9;
+	x ^= x << 8;
+	seed = x;
+	return x;
+}
+
+void NodeIdMix(unsigned int entropy)
+{
+	seed ^= entropy;
+	NodeIdRandom();
+}
+
+static unsigned long NodeIdNewNonce(void)
+{
+	NodeIdMix(TMR3);
+	return ((((unsigned long)NodeIdRandom()) << 2) ^ TMR3) & ID_NONCE_MASK;
+}
+
+/****************** INITIALIZE ******************************/
+
+/*
+ * The nonces are drawn from Timer 3, free running at Fcy : the nodes power up
+ * together, so the only thing telling them apart is when each one claims. The
+ * timer is started here unless uC/Probe already did.
+*/
+void NodeIdInit(void)
+{
+	if(!(T3CON & TON)) {
+		T3CON = 0;			// Fcy, 16 bit, prescaler 1
+		TMR3 = 0;
+		PR3 = 0xFFFF;
+		T3CON |= TON;
+	}
+	idClaimSem = OSSemCreate(0);
+}
+
+unsigned char NodeIdOwned(void)
+{
+	return owned;
+}
+
+/****************** CLAIM ***********************************/
+
+/*
+ * A claim is an extended frame whose 18 extended identifier bits hold a random
+ * nonce. When several nodes claim at the same time, the arbitration lets the
+ * lowest nonce through first and every other claimer of the same id sees it
+ * and moves on to the next id. An id is owned once a member acknowledges the
+ * claim or after ID_CLAIM_ROUNDS claims went unchallenged (the fresh nonce of
+ * each round covers the case of two identical frames merging on the bus).
+ * When every id is in use, the node stays out of the group : it shows "No free
+ * node id" on the status row, waits for a heartbeat period plus a random delay
+ * (a member may be evicted meanwhile) and claims again from the start. The
+ * node never sends with an id it does not own.
+*/
+unsigned char NodeIdClaim(unsigned char preferred)
+{
+	INT8U err;
+	unsigned char i;
+	unsigned char round;
+	unsigned char id;
+	unsigned char message[2];
+	unsigned char full = 0;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	id = (preferred < NUMBER_NODES) ? preferred : 0;
+	while(1) {
+		// First id which is neither claimed by another node nor used by a member
+		for(i = 0; i < NUMBER_NODES && (taken[id] || members[id]); i++) {
+			id = (id + 1) % NUMBER_NODES;
+		}
+		if(i == NUMBER_NODES) {
+			if(!full) {
+				DisplayLine(DISPLAY_STATUS, "No free node id");
+				full = 1;
+			}
+			OSTimeDly(ID_CLAIM_FULL_RETRY_TICKS + NodeIdRandom() % ID_CLAIM_FULL_JITTER_TICKS);
+			// The claims heard meanwhile may be stale : start over
+			for(i = 0; i < NUMBER_NODES; i++) {
+				taken[i] = 0;
+			}
+			continue;
+		}
+		for(round = 0; round < ID_CLAIM_ROUNDS; round++) {
+			OSSemSet(idClaimSem, 0, &err);
+			OS_ENTER_CRITICAL();
+			candidate = id;
+			nonce = NodeIdNewNonce();
+			result = CLAIM_PENDING;
+			OS_EXIT_CRITICAL();
+			message[0] = id;
+			message[1] = 0;
+			sendExtended(idClaim, nonce, 2, message);
+			OSSemPend(idClaimSem, ID_CLAIM_SETTLE_TICKS, &err);
+			if(result != CLAIM_PENDING) {
+				break;
+			}
+		}
+		if(result != CLAIM_LOST) {
+			owned = 1;
+			if(full) {
+				DisplayLine(DISPLAY_STATUS, "");
+			}
+			return id;
+		}
+		taken[id] = 1;
+		id = (id + 1) % NUMBER_NODES;
+	}
+}
+
+/****************** RECEPTION *******************************/
+
+void NodeIdOnClaim(BUFFER_CAN* message)
+{
+	unsigned char id;
+	unsigned char i;
+	unsigned long claimNonce;
+	unsigned char ack[ID_ACK_DLC];
+
+	if(message->DLC < 1 || message->DATA[0] >= NUMBER_NODES) {
+		return;
+	}
+	id = message->DATA[0];
+	claimNonce = (((unsigned long)message->EID17_6) << 6) | message->EID5_0;
+	NodeIdMix((unsigned int)claimNonce);
+
+	if(owned) {
+		ack[0] = id;
+		ack[1] = 0;
+		ack[2] = claimNonce & 0xFF;
+		ack[3] = (claimNonce >> 8) & 0xFF;
+		ack[4] = (claimNonce >> 16) & 0xFF;
+		if(id == candidate) {
+			// Defend our id
+			ack[5] = ID_ACK_DENIED;
+			reply(idAck, ID_ACK_DLC, ack);
+			return;
+		}
+		if(members[id] || (grantedId == id && grantedNonce != claimNonce)) {
+			// The owner answers by itself, or another claimer already got the id
+			return;
+		}
+		// Only the member with the lowest id grants, to avoid a burst of acks
+		for(i = 0; i < candidate; i++) {
+			if(members[i]) {
+				return;
+			}
+		}
+		grantedId = id;
+		grantedNonce = claimNonce;
+		ack[5] = ID_ACK_GRANTED;
+		reply(idAck, ID_ACK_DLC, ack);
+		return;
+	}
+
+	if(id == candidate && result == CLAIM_PENDING) {
+		if(claimNonce <= nonce) {
+			result = CLAIM_LOST;
+			OSSemPost(idClaimSem);
+			taken[id] = 1;
+		}
+	}
+	else {
+		taken[id] = 1;
+	}
+}
+
+void NodeIdOnAck(BUFFER_CAN* message)
+{
+	unsigned char id;
+	unsigned long ackNonce;
+
+	if(owned || message->DLC < ID_ACK_DLC || message->DATA[0] >= NUMBER_NODES) {
+		return;
+	}
+	id = message->DATA[0];
+	ackNonce = message->DATA[2] | (((unsigned long)message->DATA[3]) << 8) | (((unsigned long)message->DATA[4]) << 16);
+	if(id == candidate && ackNonce == nonce && result == CLAIM_PENDING) {
+		result = (message->DATA[5] == ID_ACK_GRANTED) ? CLAIM_ACKED : CLAIM_LOST;
+		OSSemPost(idClaimSem);
+	}
+	else if(message->DATA[5] == ID_ACK_DENIED) {
+		taken[id] = 1;
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef _NODEID_H
+#define _NODEID_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include "CanDspic.h"
+#include "Messages.h"
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define ID_CLAIM_SETTLE_TICKS	10		// Time (ticks) a claim must stay unchallenged when nobody acks it
+#define ID_CLAIM_ROUNDS			2		// Number of unchallenged claims (each with a fresh nonce) before owning the id
+#define ID_NONCE_MASK			0x3FFFFUL	// Nonces are sent in the 18 bits of the extended identifier
+
+// Layout of the idClaim payload : node id (low, high)
+// Layout of the idAck payload : node id (low, high), nonce (3 bytes, low first), verdict
+#define ID_ACK_DLC				6
+#define ID_ACK_DENIED			0		// The id is already owned by the sender of the ack
+#define ID_ACK_GRANTED			1		// The id is free in the membership of the sender of the ack
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+//! Creates the objects used by the claim protocol
+void NodeIdInit(void);
+
+//! Claims a free node id starting from 'preferred' (blocking, takes a few tens of ms)
+unsigned char NodeIdClaim(unsigned char preferred);
+
+//! Returns 1 once a node id has been claimed
+unsigned char NodeIdOwned(void);
+
+//! Mixes an unpredictable value (e.g. a free running timer) into the nonce generator
+void NodeIdMix(unsigned int entropy);
+
+//! Called by the CAN reception task for each idClaim message
+void NodeIdOnClaim(BUFFER_CAN* message);
+
+//! Called by the CAN reception task for each idAck message
+void NodeIdOnAck(BUFFER_CAN* message);
+
+#endif
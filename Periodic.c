@@ -0,0 +1,90 @@
+#include "Periodic.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+static void periodicStart(PERIODIC* periodic, INT32U now);
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * The current job is taken as released now : a task calls it before its loop,
+ * a timer callback when its timer is started.
+*/
+void PeriodicInit(PERIODIC* periodic, INT16U period)
+{
+	INT8U i;
+	periodic->release = OSTimeGet();
+	periodic->period = period;
+	periodic->maxLateness = 0;
+	periodic->jobs = 0;
+	periodic->misses = 0;
+	periodic->skipped = 0;
+	for(i = 0; i < PERIODIC_BINS; i++) {
+		periodic->lateness[i] = 0;
+	}
+}
+
+/*
+ * Ends the current job and sleeps until the release of the next one. The
+ * releases are absolute (release + period), so that neither the execution
+ * time nor the preemptions add up from one period to the next as they do with
+ * OSTimeDly(period). A job still running after the next release is a miss ; the
+ * releases already gone by are then skipped rather than run back to back.
+*/
+void PeriodicWait(PERIODIC* periodic)
+{
+	INT32U now = OSTimeGet();
+	INT32U next = periodic->release + periodic->period;
+	if((INT32S)(now - next) > 0) {
+		periodic->misses++;
+		do {
+			next += periodic->period;
+			periodic->skipped++;
+		} while((INT32S)(now - next) > 0);
+	}
+	periodic->release = next;
+	OSTimeDly((INT16U)(next - now));
+	periodicStart(periodic, OSTimeGet());
+}
+
+/*
+ * Same accounting for a job released by someone else, such as an OS timer
+ * callback : to be called when the job starts. A job starting a whole period
+ * late is a miss.
+*/
+void PeriodicRelease(PERIODIC* periodic)
+{
+	INT32U now = OSTimeGet();
+	INT32U next = periodic->release + periodic->period;
+	if((INT32S)(now - next) >= (INT32S)periodic->period) {
+		periodic->misses++;
+		do {
+			next += periodic->period;
+			periodic->skipped++;
+		} while((INT32S)(now - next) >= (INT32S)periodic->period);
+	}
+	periodic->release = next;
+	periodicStart(periodic, now);
+}
+
+/*
+ * Records when the job released at periodic->release actually started.
+*/
+static void periodicStart(PERIODIC* periodic, INT32U now)
+{
+	INT32U late = now - periodic->release;
+	INT8U bin = 0;
+	periodic->jobs++;
+	if(late > periodic->maxLateness) {
+		periodic->maxLateness = (late > 0xFFFF) ? 0xFFFF : (INT16U)late;
+	}
+	while(late != 0 && bin < PERIODIC_BINS - 1) {
+		late >>= 1;
+		bin++;
+	}
+	periodic->lateness[bin]++;
+}
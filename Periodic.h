@@ -0,0 +1,37 @@
+#ifndef _PERIODIC_H
+#define _PERIODIC_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+// Lateness histogram : bin 0 counts the jobs started on time, bin n (n > 0)
+// those started 2^(n-1) to 2^n - 1 ticks late, the last bin everything later
+#define PERIODIC_BINS	8
+
+//! Job released every 'period' ticks, at absolute times (no drift)
+typedef struct _PERIODIC
+{
+	INT32U release;					/*!< OSTimeGet() at the release of the current job	*/
+	INT16U period;					/*!< Ticks between two releases						*/
+	INT16U maxLateness;				/*!< Longest start after a release (ticks)			*/
+	INT32U jobs;					/*!< Jobs started									*/
+	INT32U misses;					/*!< Jobs not done by the next release				*/
+	INT32U skipped;					/*!< Releases dropped to catch up after a miss		*/
+	INT32U lateness[PERIODIC_BINS];	/*!< Histogram of the start times (see above)		*/
+} PERIODIC;
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void PeriodicInit(PERIODIC* periodic, INT16U period);
+void PeriodicWait(PERIODIC* periodic);
+void PeriodicRelease(PERIODIC* periodic);
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef PERSIST_HOST_EMULATION
+#include <includes.h>
+#endif
+#include "Persist.h"
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define PERSIST_SLOTS_PER_PAGE	(PERSIST_PAGE_WORDS / PERSIST_RECORD_WORDS)
+#define PERSIST_SLOTS			(PERSIST_PAGES * PERSIST_SLOTS_PER_PAGE)
+#define PERSIST_ERASED			0xFFFF		// Value of an erased word, never used as a sequence number
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+static unsigned char loaded = 0;			// 1 once the region has been scanned
+static unsigned char lastValid = 0;			// 1 if 'lastSaved' holds the most recent record
+static unsigned int nextSlot = 0;			// Slot where the next record will be written
+static PERSIST_RECORD lastSaved;
+
+/********************************************************
+*						FLASH ACCESS					*
+********************************************************/
+
+#ifdef PERSIST_HOST_EMULATION
+
+// Flash emulated in RAM, for the host test (bench/PersistTest.c)
+unsigned int persistHostFlash[PERSIST_PAGES*PERSIST_PAGE_WORDS];
+unsigned long persistHostErases[PERSIST_PAGES];
+
+static unsigned int FlashRead(unsigned int index)
+{
+	return persistHostFlash[index];
+}
+
+static void FlashWrite(unsigned int index, unsigned int value)
+{
+	// As on the device, programming can only clear bits
+	persistHostFlash[index] &= value;
+}
+
+static void FlashErasePage(unsigned char page)
+{
+	unsigned int i;
+
+	for(i = 0; i < PERSIST_PAGE_WORDS; i++) {
+		persistHostFlash[page*PERSIST_PAGE_WORDS + i] = PERSIST_ERASED;
+	}
+	persistHostErases[page]++;
+}
+
+void PersistHostReset(void)
+{
+	unsigned char page;
+
+	for(page = 0; page < PERSIST_PAGES; page++) {
+		FlashErasePage(page);
+		persistHostErases[page] = 0;
+	}
+	loaded = 0;
+	lastValid = 0;
+	nextSlot = 0;
+}
+
+#else
+
+//! Region of program memory holding the records (only the lower 16 bits of each instruction are used)
+static const unsigned int persistArea[PERSIST_PAGES*PERSIST_PAGE_WORDS] __attribute__((space(prog), aligned(PERSIST_PAGES*PERSIST_PAGE_WORDS*2))) = {[0 ... PERSIST_PAGES*PERSIST_PAGE_WORDS-1] = PERSIST_ERASED};
+
+static unsigned int FlashRead(unsigned int index)
+{
+	TBLPAG = __builtin_tblpage(persistArea);
+	return __builtin_tblrdl(__builtin_tbloffset(persistArea) + 2*index);
+}
+
+/*
+ * The CPU stalls while the flash is programmed : about 40us for a word and
+ * 20ms for a page erase, which only happens once every PERSIST_SLOTS_PER_PAGE
+ * records.
+*/
+static void FlashWrite(unsigned int index, unsigned int value)
+{
+	unsigned int offset;
+
+	NVMCON = 0x4003;							// Program a single word
+	TBLPAG = __builtin_tblpage(persistArea);
+	offset = __builtin_tbloffset(persistArea) + 2*index;
+	__builtin_tblwtl(offset, value);
+	__builtin_tblwth(offset, 0xFF);
+	__builtin_write_NVM();						// Unlock sequence and start of the operation
+	while(NVMCONbits.WR);
+}
+
+static void FlashErasePage(unsigned char page)
+{
+	NVMCON = 0x4042;							// Erase a page
+	TBLPAG = __builtin_tblpage(persistArea);
+	__builtin_tblwtl(__builtin_tbloffset(persistArea) + 2*page*PERSIST_PAGE_WORDS, 0);
+	__builtin_write_NVM();						// Unlock sequence and start of the operation
+	while(NVMCONbits.WR);
+}
+
+#endif
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/****************** RECORD ENCODING *************************/
+
+static unsigned int PersistChecksum(unsigned int* words)
+{
+	unsigned char i;
+	unsigned int sum = 0x5A5A;
+
+	for(i = 0; i < PERSIST_RECORD_WORDS-1; i++) {
+		sum = (((sum << 1) | (sum >> 15)) ^ words[i]) & 0xFFFF;
+	}
+	return sum;
+}
+
+static void PersistPack(PERSIST_RECORD* record, unsigned int* words)
+{
+	words[0] = record->sequence;
+	words[1] = record->nodeId | (record->state << 8);
+	words[2] = record->configGeneration | (record->passwordGeneration << 8);
+	words[3] = (unsigned char)record->password[0] | ((unsigned char)record->password[1] << 8);
+	words[4] = (unsigned char)record->password[2] | ((unsigned char)record->password[3] << 8);
+	words[5] = record->idleCtrMax & 0xFFFF;
+	words[6] = (record->idleCtrMax >> 16) & 0xFFFF;
+	words[7] = PersistChecksum(words);
+}
+
+static unsigned char PersistUnpack(unsigned int* words, PERSIST_RECORD* record)
+{
+	if(words[0] == PERSIST_ERASED || words[7] != PersistChecksum(words)) {
+		return 0;
+	}
+	record->sequence			= words[0];
+	record->nodeId				= words[1] & 0xFF;
+	record->state				= words[1] >> 8;
+	record->configGeneration	= words[2] & 0xFF;
+	record->passwordGeneration	= words[2] >> 8;
+	record->password[0]			= words[3] & 0xFF;
+	record->password[1]			= words[3] >> 8;
+	record->password[2]			= words[4] & 0xFF;
+	record->password[3]			= words[4] >> 8;
+	record->idleCtrMax			= words[5] | ((unsigned long)words[6] << 16);
+	return 1;
+}
+
+static unsigned char PersistSame(PERSIST_RECORD* a, PERSIST_RECORD* b)
+{
+	unsigned char i;
+
+	for(i = 0; i < PERSIST_PASSWORD_SIZE; i++) {
+		if(a->password[i] != b->password[i]) {
+			return 0;
+		}
+	}
+	return a->nodeId == b->nodeId && a->state == b->state
+		&& a->configGeneration == b->configGeneration && a->passwordGeneration == b->passwordGeneration
+		&& a->idleCtrMax == b->idleCtrMax;
+}
+
+/****************** SLOTS ***********************************/
+
+static void PersistReadSlot(unsigned int slot, unsigned int* words)
+{
+	unsigned char i;
+
+	for(i = 0; i < PERSIST_RECORD_WORDS; i++) {
+		words[i] = FlashRead(slot*PERSIST_RECORD_WORDS + i);
+	}
+}
+
+static unsigned char PersistSlotBlank(unsigned int slot)
+{
+	unsigned char i;
+
+	for(i = 0; i < PERSIST_RECORD_WORDS; i++) {
+		if(FlashRead(slot*PERSIST_RECORD_WORDS + i) != PERSIST_ERASED) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Looks for the valid record with the most recent sequence number. Records
+ * whose checksum fails (e.g. power lost while writing) are skipped.
+*/
+static void PersistScan(void)
+{
+	unsigned int slot;
+	unsigned int words[PERSIST_RECORD_WORDS];
+	PERSIST_RECORD record;
+
+	lastValid = 0;
+	nextSlot = 0;
+	for(slot = 0; slot < PERSIST_SLOTS; slot++) {
+		PersistReadSlot(slot, words);
+		if(PersistUnpack(words, &record)) {
+			if(!lastValid || (short)(record.sequence - lastSaved.sequence) > 0) {
+				lastSaved = record;
+				lastValid = 1;
+				nextSlot = (slot + 1) % PERSIST_SLOTS;
+			}
+		}
+	}
+	loaded = 1;
+}
+
+/****************** LOAD ************************************/
+
+unsigned char PersistLoad(PERSIST_RECORD* record)
+{
+	PersistScan();
+	if(lastValid) {
+		*record = lastSaved;
+	}
+	return lastValid;
+}
+
+/****************** SAVE ************************************/
+
+/*
+ * Records are appended one after the other, so that each page is erased only
+ * once it is full (wear leveling). A page is erased when the writing enters
+ * it, the most recent record being always in the other page at that moment.
+*/
+void PersistSave(PERSIST_RECORD* record)
+{
+	unsigned int i;
+	unsigned int words[PERSIST_RECORD_WORDS];
+
+	if(!loaded) {
+		PersistScan();
+	}
+	if(lastValid && PersistSame(record, &lastSaved)) {
+		return;
+	}
+	record->sequence = lastValid ? (lastSaved.sequence + 1) & 0xFFFF : 0;
+	if(record->sequence == PERSIST_ERASED) {
+		record->sequence = 0;
+	}
+	PersistPack(record, words);
+
+	for(i = 0; i < PERSIST_SLOTS; i++) {
+		if((nextSlot % PERSIST_SLOTS_PER_PAGE) == 0 && !PersistSlotBlank(nextSlot)) {
+			FlashErasePage(nextSlot / PERSIST_SLOTS_PER_PAGE);
+		}
+		if(PersistSlotBlank(nextSlot)) {
+			break;
+		}
+		nextSlot = (nextSlot + 1) % PERSIST_SLOTS;
+	}
+	for(i = 0; i < PERSIST_RECORD_WORDS; i++) {
+		FlashWrite(nextSlot*PERSIST_RECORD_WORDS + i, words[i]);
+	}
+	nextSlot = (nextSlot + 1) % PERSIST_SLOTS;
+	lastSaved = *record;
+	lastValid = 1;
+}
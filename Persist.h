@@ -0,0 +1,47 @@
+#ifndef _PERSIST_H
+#define _PERSIST_H
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define PERSIST_PAGE_WORDS		512		// Instructions per erase page of the dsPIC33FJ
+#define PERSIST_PAGES			2		// Records alternate between two pages
+#define PERSIST_RECORD_WORDS	8		// Words (lower 16 bits of an instruction) per record
+#define PERSIST_PASSWORD_SIZE	4
+
+/********************************************************
+*						VARIABLES						*
+********************************************************/
+
+//! State kept across resets
+typedef struct _PERSIST_RECORD
+{
+	unsigned int sequence;							/*!< Incremented on each save, set by PersistSave()	*/
+	unsigned char nodeId;							/*!< Claimed node id								*/
+	unsigned char state;							/*!< HB_STATE_xxx bits								*/
+	unsigned char configGeneration;					/*!< Arming/disarming generation					*/
+	unsigned char passwordGeneration;				/*!< Password generation							*/
+	char password[PERSIST_PASSWORD_SIZE];			/*!< System password								*/
+	unsigned long idleCtrMax;						/*!< OSIdleCtrMax measured by OSStatInit()			*/
+} PERSIST_RECORD;
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+//! Finds the most recent valid record, returns 1 if one was found
+unsigned char PersistLoad(PERSIST_RECORD* record);
+
+//! Appends the record to the flash if it differs from the last one saved
+void PersistSave(PERSIST_RECORD* record);
+
+#ifdef PERSIST_HOST_EMULATION
+//! Emulated flash region and erase count of each page
+extern unsigned int persistHostFlash[PERSIST_PAGES*PERSIST_PAGE_WORDS];
+extern unsigned long persistHostErases[PERSIST_PAGES];
+
+//! Erases the emulated region and forgets the last record (simulates a blank device)
+void PersistHostReset(void);
+#endif
+
+#endif
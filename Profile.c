@@ -0,0 +1,111 @@
+#include "Profile.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+PROFILE profile[PROFILE_TASKS];
+static PROFILE profileLive[PROFILE_TASKS];			// Written by the switch hook
+static INT32U profilePublished[PROFILE_TASKS];		// profileLive[].cycles at the last publication
+static INT8U profileSlot[OS_LOWEST_PRIO + 1];		// Slot of each priority (PROFILE_NONE : none)
+static INT8U profileSlots = 0;
+static INT32U profileSwitchedIn;					// Cycle counter when the current task was switched in
+static INT32U profilePublishedAt;
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * Called by App_TaskCreateHook (interrupts disabled) : the task gets the next
+ * free slot. The tasks created once PROFILE_TASKS are used are not accounted.
+*/
+void ProfileTaskCreate(OS_TCB* ptcb)
+{
+	INT8U i;
+	PROFILE* p;
+	if(profileSlots == 0) {
+		for(i = 0; i <= OS_LOWEST_PRIO; i++) {
+			profileSlot[i] = PROFILE_NONE;
+		}
+		for(i = 0; i < PROFILE_TASKS; i++) {
+			profileLive[i].prio = PROFILE_NONE;
+			profile[i].prio = PROFILE_NONE;
+		}
+	}
+	if(profileSlots >= PROFILE_TASKS || profileSlot[ptcb->OSTCBPrio] != PROFILE_NONE) {
+		return;
+	}
+	p = &profileLive[profileSlots];
+	p->prio = ptcb->OSTCBPrio;
+	p->load = 0;
+	p->cycles = 0;
+	p->sliceMin = 0xFFFFFFFF;
+	p->sliceMax = 0;
+	p->runs = 0;
+	p->preemptions = 0;
+	profilePublished[profileSlots] = 0;
+	profileSlot[ptcb->OSTCBPrio] = profileSlots++;
+}
+
+/*
+ * Called by App_TaskSwHook (interrupts disabled), OSTCBCur being switched out
+ * for OSTCBHighRdy : the slice of OSTCBCur ends now. The interrupts it was
+ * preempted by are counted in its slice.
+*/
+void ProfileSwitch(void)
+{
+	INT32U now = BSP_CycleTmrRd();
+	INT32U slice = now - profileSwitchedIn;
+	INT8U slot;
+	PROFILE* p;
+
+	profileSwitchedIn = now;
+	slot = profileSlot[OSTCBCur->OSTCBPrio];
+	if(slot != PROFILE_NONE && profileSlots != 0) {
+		p = &profileLive[slot];
+		p->cycles += slice;
+		if(slice < p->sliceMin) {
+			p->sliceMin = slice;
+		}
+		if(slice > p->sliceMax) {
+			p->sliceMax = slice;
+		}
+		if(OSTCBCur->OSTCBStat == OS_STAT_RDY && OSTCBCur->OSTCBDly == 0) {
+			p->preemptions++;		// still ready : a higher priority task took the CPU
+		}
+	}
+	slot = profileSlot[OSTCBHighRdy->OSTCBPrio];
+	if(slot != PROFILE_NONE && profileSlots != 0) {
+		profileLive[slot].runs++;
+	}
+}
+
+/*
+ * Called by App_TaskStatHook once per statistics period : copies the figures
+ * to profile[] at once, so that a reader never sees them half updated, with
+ * the share of the period each task ran.
+*/
+void ProfilePublish(void)
+{
+	INT8U i;
+	INT32U now = BSP_CycleTmrRd();
+	INT32U period = (now - profilePublishedAt) / 1000;
+	PROFILE snapshot;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	profilePublishedAt = now;
+	if(period == 0) {
+		return;
+	}
+	for(i = 0; i < profileSlots; i++) {
+		OS_ENTER_CRITICAL();
+		snapshot = profileLive[i];
+		OS_EXIT_CRITICAL();
+		snapshot.load = (INT16U)((snapshot.cycles - profilePublished[i]) / period);
+		profilePublished[i] = snapshot.cycles;
+		profile[i] = snapshot;
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef _PROFILE_H
+#define _PROFILE_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define PROFILE_TASKS		12			// Tasks accounted, in the order of their creation (OS tasks included)
+#define PROFILE_NONE		0xFF
+
+//! CPU time of one task, published by ProfilePublish()
+typedef struct _PROFILE
+{
+	INT8U prio;				/*!< Priority of the task (PROFILE_NONE : slot free)				*/
+	INT16U load;			/*!< Share of the last statistics period (0.1%)						*/
+	INT32U cycles;			/*!< Cycles run since the start (wraps every 107s at 40MHz)			*/
+	INT32U sliceMin;		/*!< Shortest run between being switched in and out (cycles)		*/
+	INT32U sliceMax;		/*!< Longest one												*/
+	INT32U runs;			/*!< Times switched in												*/
+	INT32U preemptions;		/*!< Times switched out while still ready (preempted, not blocked)	*/
+} PROFILE;
+
+extern PROFILE profile[PROFILE_TASKS];	// Read with uC/Probe or the debugger
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void ProfileTaskCreate(OS_TCB* ptcb);
+void ProfileSwitch(void);
+void ProfilePublish(void);
+
+#endif
@@ -0,0 +1,106 @@
+#include "Stack.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+STACK_USAGE stackUsage[STACK_TASKS];
+INT16U stackReclaimable;
+static INT8U stackSlots = 0;
+
+static STACK_USAGE* StackSlot(INT8U prio);
+static INT16U StackRecommended(INT16U peak);
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * Called by App_TaskStatHook once per statistics period : updates the peak
+ * of every task and the size recommended from it. The tasks being created
+ * with OS_TASK_OPT_STK_CLR, the words ever written are told apart from the
+ * cleared ones : the usage found is the high-water mark since the creation.
+ * When the statistics task checks the stacks itself (OS_TASK_STAT_STK_CHK_EN),
+ * its figures are taken rather than scanning the stacks twice.
+*/
+void StackMonitor(void)
+{
+	INT8U prio;
+	OS_TCB* ptcb;
+	INT16U size;
+	INT16U used;
+	INT16U reclaimable = 0;
+	STACK_USAGE* usage;
+#if OS_TASK_STAT_STK_CHK_EN == 0
+	OS_STK_DATA data;
+#endif
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	for(prio = 0; prio <= OS_LOWEST_PRIO; prio++) {
+		OS_ENTER_CRITICAL();
+		ptcb = OSTCBPrioTbl[prio];
+		if(ptcb == (OS_TCB*)0 || ptcb == OS_TCB_RESERVED) {
+			OS_EXIT_CRITICAL();
+			continue;
+		}
+		size = (INT16U)ptcb->OSTCBStkSize;
+#if OS_TASK_STAT_STK_CHK_EN > 0
+		used = (INT16U)(ptcb->OSTCBStkUsed / sizeof(OS_STK));
+		OS_EXIT_CRITICAL();
+#else
+		OS_EXIT_CRITICAL();
+		if(OSTaskStkChk(prio, &data) != OS_ERR_NONE) {
+			continue;
+		}
+		used = (INT16U)(data.OSUsed / sizeof(OS_STK));
+#endif
+		usage = StackSlot(prio);
+		if(usage == (STACK_USAGE*)0) {
+			continue;
+		}
+		usage->size = size;
+		if(used > usage->peak) {
+			usage->peak = used;
+			usage->recommended = StackRecommended(used);
+		}
+		if(usage->size > usage->recommended) {
+			reclaimable += usage->size - usage->recommended;
+		}
+	}
+	stackReclaimable = reclaimable;
+}
+
+/*
+ * Slot of the task at 'prio', given on its first check. Returns 0 once the
+ * STACK_TASKS slots are used.
+*/
+static STACK_USAGE* StackSlot(INT8U prio)
+{
+	INT8U i;
+	STACK_USAGE* usage;
+	for(i = 0; i < stackSlots; i++) {
+		if(stackUsage[i].prio == prio) {
+			return &stackUsage[i];
+		}
+	}
+	if(stackSlots >= STACK_TASKS) {
+		return (STACK_USAGE*)0;
+	}
+	usage = &stackUsage[stackSlots++];
+	usage->prio = prio;
+	usage->peak = 0;
+	usage->recommended = StackRecommended(0);
+	return usage;
+}
+
+/*
+ * The interrupts use the stack of the task they preempt : the margins leave
+ * room for a deeper nesting, or a longer path, than the one seen so far.
+*/
+static INT16U StackRecommended(INT16U peak)
+{
+	INT32U words = (INT32U)peak * (100 + STACK_MARGIN_PCT) / 100 + STACK_ISR_WORDS;
+	return (INT16U)((words + STACK_ROUND_WORDS - 1) / STACK_ROUND_WORDS * STACK_ROUND_WORDS);
+}
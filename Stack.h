@@ -0,0 +1,36 @@
+#ifndef _STACK_H
+#define _STACK_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define STACK_TASKS			12			// Tasks monitored, in the order they are first seen (OS tasks included)
+#define STACK_MARGIN_PCT	20			// Added to the peak in the recommended size (%)
+#define STACK_ISR_WORDS		32			// And room for interrupts nesting deeper than seen (words)
+#define STACK_ROUND_WORDS	8			// The recommended size is a multiple of this
+
+//! Stack usage of one task, in words (OS_STK)
+typedef struct _STACK_USAGE
+{
+	INT8U prio;				/*!< Priority of the task									*/
+	INT16U size;			/*!< Size it was given (0 : slot free)						*/
+	INT16U peak;			/*!< Most ever used (the stacks are cleared at creation)	*/
+	INT16U recommended;		/*!< Peak with the margins, rounded up						*/
+} STACK_USAGE;
+
+extern STACK_USAGE stackUsage[STACK_TASKS];	// Read with uC/Probe or the debugger
+extern INT16U stackReclaimable;				// Words of all the stacks above their recommended size
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void StackMonitor(void);
+
+#endif
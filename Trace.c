@@ -0,0 +1,74 @@
+#include "Trace.h"
+
+#if APP_TRACE_EN > 0
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+TRACE trace;
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * The time stamps are those of the cycle counter of the BSP, started by
+ * BSP_Init : it wraps every 107s, which tools/trace2json.c unwraps.
+*/
+void TraceInit(void)
+{
+	trace.count = 0;
+	trace.size = TRACE_EVENTS;
+	trace.left = 0xFFFF;
+	trace.frequency = BSP_CPU_ClkFrq();
+}
+
+/*
+ * Writes a record in the ring, over the oldest one. Callable from the tasks,
+ * the interrupts and the OS hooks : about 40 cycles (1us at 40MHz).
+ * Once triggered, the ring stops after TRACE_EVENTS / 2 more records.
+*/
+void TraceRecord(INT8U type, INT8U id, INT16U arg)
+{
+	TRACE_RECORD* record;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	OS_ENTER_CRITICAL();
+	if(trace.left == 0) {
+		OS_EXIT_CRITICAL();
+		return;
+	}
+	if(trace.left != 0xFFFF) {
+		trace.left--;
+	}
+	record = &trace.records[(INT16U)trace.count & (TRACE_EVENTS - 1)];
+	trace.count++;
+	record->time = BSP_CycleTmrRd();
+	record->type = type;
+	record->id = id;
+	record->arg = arg;
+	OS_EXIT_CRITICAL();
+}
+
+/*
+ * Freezes the ring around an incident : half of it holds what led to the
+ * trigger, the other half what followed. The first trigger only counts.
+*/
+void TraceTrigger(void)
+{
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+
+	TraceRecord(TRACE_TRIGGER, 0, TRACE_EVENTS / 2);
+	OS_ENTER_CRITICAL();
+	if(trace.left == 0xFFFF) {
+		trace.left = TRACE_EVENTS / 2;
+	}
+	OS_EXIT_CRITICAL();
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+#define TRACE_EVENTS		512			// Records of the ring (8 bytes each, power of 2)
+#define TRACE_TICKS_EN		1			// Record the ticks (0 : the ring covers more time)
+
+// Record types (tools/trace2json.c decodes them)
+#define TRACE_SWITCH		1			// id : task switched in, arg : task switched out (priorities)
+#define TRACE_TICK			2			// arg : OSTime (low word)
+#define TRACE_ISR_ENTER		3			// id : TRACE_ISR_xxx
+#define TRACE_ISR_EXIT		4			// id : TRACE_ISR_xxx
+#define TRACE_MUTEX_PEND	5			// id : event, arg : priority of the caller
+#define TRACE_MUTEX_TAKEN	6			// id : event, arg : priority of the caller
+#define TRACE_MUTEX_POST	7			// id : event, arg : priority of the caller
+#define TRACE_Q_POST		8			// id : event, arg : message (low word)
+#define TRACE_Q_GET			9			// id : event, arg : message (low word)
+#define TRACE_TRIGGER		10			// arg : TRACE_EVENTS / 2, the records kept after it
+
+// Interrupts (ids of TRACE_ISR_ENTER / TRACE_ISR_EXIT)
+#define TRACE_ISR_BUTTON_IC5	1
+#define TRACE_ISR_BUTTON_IC6	2
+#define TRACE_ISR_ANALOG_DMA2	3
+#define TRACE_ISR_CAN_RX		4		// The LCD Timer 1 is left out : it would fill the ring every 20ms
+
+//! One record : 8 bytes, little endian
+typedef struct _TRACE_RECORD
+{
+	INT32U time;		/*!< Cycles (Fcy), BSP_CycleTmrRd()					*/
+	INT8U type;			/*!< TRACE_xxx										*/
+	INT8U id;			/*!< Task, interrupt or event (see the types)		*/
+	INT16U arg;
+} TRACE_RECORD;
+
+//! The ring, dumped as is from the debugger for tools/trace2json.c
+typedef struct _TRACE
+{
+	INT32U count;						/*!< Records written since TraceInit (the next one is count % TRACE_EVENTS)	*/
+	INT16U size;						/*!< TRACE_EVENTS															*/
+	INT16U left;						/*!< Records still written after a trigger (0xFFFF : not triggered)			*/
+	INT32U frequency;					/*!< Of the time stamps (Hz)												*/
+	TRACE_RECORD records[TRACE_EVENTS];
+} TRACE;
+
+extern TRACE trace;			// Only built with APP_TRACE_EN
+
+#if APP_TRACE_EN > 0
+#define TRACE_RECORD_ADD(type, id, arg)	TraceRecord((type), (INT8U)(id), (INT16U)(arg))
+#define TRACE_EVENT_ADD(type, event, arg)	TraceRecord((type), (INT8U)((event) - OSEventTbl), (INT16U)(arg))
+#else
+#define TRACE_RECORD_ADD(type, id, arg)
+#define TRACE_EVENT_ADD(type, event, arg)
+#endif
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void TraceInit(void);
+void TraceRecord(INT8U type, INT8U id, INT16U arg);
+void TraceTrigger(void);
+
+#endif
@@ -0,0 +1,86 @@
+#include "Zones.h"
+#include "Debounce.h"
+#include "Alarm.h"
+#include "elec-h-410.h"
+
+/********************************************************
+*						DECLARATIONS					*
+********************************************************/
+
+#define ZONES_USED		(ZONES_DELAYED | ZONES_INSTANT | ZONES_24H)
+
+static OS_EVENT* zoneQueue;						// Alarm events (ALARM_EVENT cast to a pointer)
+static DEBOUNCE zoneDebounce;					// One bit per zone
+static unsigned char zoneCountdown = 0;
+static INT8U zonesTripped = 0;					// Zones tripped since the last ZonesClear()
+
+/********************************************************
+*						FUNCTIONS						*
+********************************************************/
+
+/*
+ * DIO1-DIO8 are set as inputs by init_elec_h_410, which must be called first.
+ * Every zone starts idle : a zone already tripped is reported by the first
+ * snapshots.
+*/
+void ZonesInit(OS_EVENT* alarmQueue)
+{
+	zoneQueue = alarmQueue;
+	DebounceInit(&zoneDebounce, 0, ZONE_DEBOUNCE_SAMPLES);
+}
+
+/*
+ * Snapshot of the eight lines, bit n set when zone n is tripped. Two port
+ * reads and a few shifts, whatever the number of zones.
+*/
+static INT8U ZonesRead(void)
+{
+	INT8U lines = ((PORTC >> 1) & 0x0F) | ((PORTG >> 8) & 0xF0);
+	return (lines ^ ZONES_ACTIVE_LOW) & ZONES_USED;
+}
+
+/*
+ * Called every tick by App_TimeTickHook. Every ZONE_SCAN_TICKS, the snapshot
+ * of all the zones is debounced at once (see Debounce.c). The zones newly
+ * tripped are then sorted by mode with three masks, each mode being one event
+ * of the state machine, posted at most once per snapshot : the cost does not
+ * depend on the number of zones or of zones tripped.
+*/
+void ZonesTickHook(void)
+{
+	INT8U tripped;
+
+	if(zoneCountdown) {
+		zoneCountdown--;
+		return;
+	}
+	zoneCountdown = ZONE_SCAN_TICKS - 1;
+	tripped = DebounceSample(&zoneDebounce, ZonesRead()) & zoneDebounce.state;
+	if(!tripped) {
+		return;
+	}
+	zonesTripped |= tripped;
+	if(tripped & ZONES_24H) {
+		OSQPost(zoneQueue, (void*)(INT16U)EV_ZONE_24H);
+	}
+	if(tripped & ZONES_INSTANT) {
+		OSQPost(zoneQueue, (void*)(INT16U)EV_ZONE_INSTANT);
+	}
+	if(tripped & ZONES_DELAYED) {
+		OSQPost(zoneQueue, (void*)(INT16U)EV_INTRUSION);
+	}
+}
+
+/*
+ * Bitmap of the zones tripped since the last ZonesClear(), sent with the
+ * intrusion frames.
+*/
+INT8U ZonesTripped(void)
+{
+	return zonesTripped;
+}
+
+void ZonesClear(void)
+{
+	zonesTripped = 0;
+}
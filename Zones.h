@@ -0,0 +1,33 @@
+#ifndef _ZONES_H
+#define _ZONES_H
+/********************************************************
+*						HEADERS							*
+********************************************************/
+
+#include <includes.h>
+
+/********************************************************
+*						DEFINITIONS						*
+********************************************************/
+
+// Sensor zones : bit n is DIO(n+1) (DIO1-4 on RC1-RC4, DIO5-8 on RG12-RG15)
+#define ZONES					8
+#define ZONE_SCAN_TICKS			5			// Period (ticks) of the zone snapshot
+#define ZONE_DEBOUNCE_SAMPLES	4			// Snapshots a zone must agree before it changes (1-7)
+
+// Wiring of the panel : one bit per zone, a zone in none of the masks is unused
+#define ZONES_DELAYED			0x03		// Entry delay first (doors)
+#define ZONES_INSTANT			0x3C		// Alarm at once while armed
+#define ZONES_24H				0x40		// Alarm at once, even disarmed (tamper, panic)
+#define ZONES_ACTIVE_LOW		0x00		// Zones whose sensor pulls the line low when tripped
+
+/********************************************************
+*						PROTOTYPES						*
+********************************************************/
+
+void ZonesInit(OS_EVENT* alarmQueue);
+void ZonesTickHook(void);
+INT8U ZonesTripped(void);
+void ZonesClear(void);
+
+#endif
@@ -26,6 +26,20 @@
 #include "Keyboard.h"	// Keyboard functions library
 #include "elec-h-410.h"
 #include "CanDspic.h"
+#include "Messages.h"
+#include "HeartBeat.h"
+#include "NodeId.h"
+#include "Membership.h"
+#include "Alarm.h"
+#include "Persist.h"
+#include "Buttons.h"
+#include "Zones.h"
+#include "Analog.h"
+#include "Display.h"
+#include "Lcd.h"
+#include "Periodic.h"
+#include "Trace.h"
+#include "Lock.h"
 #include <string.h> // useful ??
 
 /*
@@ -35,20 +49,13 @@
 */
 // Inputs have beeen prioritised over the outputs and the background tasks are left in the middle.
 #define  APP_TASK_START_PRIO                    2                       // Lower numbers are of higher priority
-#define  Keyboard_Task_PRIO						11						//Priority for the keyboard task
+#define  Can_Rx_Task_PRIO						11						//Priority for the CAN reception task
 #define  Password_Management_Task_PRIO			14						//Priority for the password manager task
 #define  Button_handler_Task_PRIO				12						//Priority for the INTRUSION task
+#define  Frame_Task_PRIO						12						//Priority for the cyclic executive (replaces the two above)
+#define  Alarm_Task_PRIO						13						//Priority for the alarm state machine task
 #define  APP_TASK_LCD_PRIO                      16						//Priority for the LCD MANAGER task (Lowest)
 
-/*
-*********************************************************************************************************
-*                                       TASK PERIODS
-*********************************************************************************************************
-*/
-#define	 Keyboard_Task_PERIOD					100
-#define  Password_Management_Task_PERIOD		100
-#define  Button_handler_Task_PERIOD				100
-
 /*
 *********************************************************************************************************
 *                                       TASK STACK SIZES
@@ -75,45 +82,81 @@ const INT8U hex2ASCII[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '
 //////////////////////////////////////////////////////////////////////////////
 // Tasks stack
 OS_STK  AppTaskStartStk[APP_TASK_START_STK_SIZE];
-OS_STK  KeyboardTaskStk[APP_TASK_STK_SIZE];
+#if APP_CYCLIC_EXEC_EN > 0
+OS_STK  FrameTaskStk[APP_TASK_STK_SIZE];
+#else
 OS_STK  PasswordManagementTaskStk[APP_TASK_STK_SIZE];
 OS_STK  ButtonHandlerTaskStk[APP_TASK_STK_SIZE];
+#endif
+OS_STK  CanRxTaskStk[APP_TASK_STK_SIZE];
+OS_STK  AlarmTaskStk[APP_TASK_STK_SIZE];
 OS_STK  AppLCDTaskStk[APP_TASK_LCD_STK_SIZE];
 
 // Definition of some constants
 #define PWDSIZE		 4
 #define STARCHAR     42		// Encoding of the 'star' character *
 #define NODE_ID      10		// Starting condition only
-#define OFFSET       0x200	// Offset to identify our node in the CAN
-#define NUMBER_NODES 10 	// Upper bound (maximum 10 nodes 0-9)
 
 // Programmer defined variables
 // Password related variables
 unsigned char nodeId[1] = {NODE_ID}; //Read only variable
 char nodeIdentity[PWDSIZE+1] = {NODE_ID, 'B', '1', '6', '9'};
 char* systemProvidedCode = &nodeIdentity[1];
-// Flags/system-states declaration and definition
-unsigned char flagSystemUnlocked = 0;
-unsigned char flagTimerActivated = 0;
-unsigned char flagPasswordChange = 0;
-// Mailboxes related variables
-char lcdpmsg[PWDSIZE+1] = "    "; 	// the '+1' is due to the eos character
-char pmsg[PWDSIZE+1] = "    "; 		// the '+1' is due to the eos character
-// HeartBeat related variables
-unsigned char IDcounter = 0; 		//Read only
-unsigned char HBflags[10]   = {0, 0 ,0 ,0 ,0 ,0 ,0 ,0 ,0 ,0};
-unsigned char HBCounter[10] = {0, 0 ,0 ,0 ,0 ,0 ,0 ,0 ,0 ,0};
-
-// Mailboxes declaration
-OS_EVENT* myBox;
-OS_EVENT* lcdBox;
-
-// Mutexes declaration - generally there is one mutex per global variable/flag
+// System state word : one bit per flag, the HB_STATE_xxx bits of the heartbeat
+OS_FLAG_GRP* systemState;
+#define STATE_UNLOCKED		HB_STATE_UNLOCKED
+#define STATE_TIMER			HB_STATE_TIMER
+#define STATE_ALARM			HB_STATE_ALARM
+#define STATE_PWD_CHANGE	HB_STATE_PWD_CHANGE
+// Membership related variables (the view itself is in Membership.c)
+unsigned char membershipLeft = 0;		// 1 while the node is out of the group for maintenance
+// Generations advertised in the heartbeat, used to converge on the latest state
+unsigned char configGeneration = 0;		// Incremented on each arming/disarming
+unsigned char passwordGeneration = 0;	// Incremented on each password change
+
+// Password management : keypad events (KEY_EVENT*) and mode changes (&passwordModeChanged) queued for PasswordManagementTask
+#define PASSWORD_Q_SIZE	(KEY_EVENT_POOL + 2)	// every key event of the pool fits, plus the mode changes
+OS_EVENT* passwordQ;
+void* passwordQStorage[PASSWORD_Q_SIZE];
+char passwordModeChanged;
+
+// CAN reception : each frame received is copied in a message of canRxPool, queued for CanRxTask
+#define CAN_RX_POOL		8
+#define CAN_RX_Q_SIZE	CAN_RX_POOL
+INT16U canRxStorage[CAN_RX_POOL][MSG_BLOCK_WORDS(BUFFER_CAN)];
+MSG_POOL canRxPool;
+OS_EVENT* canRxQ;
+void* canRxQStorage[CAN_RX_Q_SIZE];
+
+#define PWD_STEP_CHECK		0		// a code locks/unlocks the system
+#define PWD_STEP_OLD		1		// password change : old password expected
+#define PWD_STEP_NEW		2		// password change : new password expected
+#define PWD_STEP_CONFIRM	3		// password change : new password again
+
+#if APP_PWD_BENCH_EN > 0
+// Keypress-to-unlock latency and password task wake-ups (read with uC/Probe or the debugger)
+INT32U pwdBenchCodeTime;		// BSP_CycleTmrRd() when the last key of a code was pressed
+INT32U pwdBenchLatency;			// us from the last key of the code to the unlock
+INT32U pwdBenchLatencyMax;
+INT32U pwdBenchWakeups;			// PasswordManagementTask wake-ups (one per event posted)
+#endif
+
+// Alarm state machine : events (ALARM_EVENT cast to a pointer) queued for AlarmTask
+#define ALARM_Q_SIZE	16
+OS_EVENT* alarmQ;
+void* alarmQStorage[ALARM_Q_SIZE];
+unsigned char alarmState = ALARM_ARMED;		// written by AlarmTask only (ALARM_STATE)
+
+// Posted by the button driver when INTRUSION is held (maintenance leave/rejoin)
+OS_EVENT* buttonHold;
+
+#if APP_BUTTON_BENCH_EN > 0
+INT16U buttonBenchCycles;		// Cycles from the intrusion edge to send(intrusion)
+INT16U buttonBenchCyclesMax;
+#endif
+
+// Mutexes declaration - for the shared data which is not a flag of the state word
 OS_EVENT *heartBeatMutex;
-OS_EVENT *alarmStartedMutex;
-OS_EVENT *flagPasswordChangeMutex;
-OS_EVENT *flagSystemUnlockedMutex;
-OS_EVENT *flagTimerActivatedMutex;
 OS_EVENT *systemProvidedCodeMutex;
 
 // Timers declaration
@@ -121,30 +164,46 @@ OS_TMR* heartBeatTimer;
 OS_TMR* timerTimer;
 OS_TMR* HBCheckerTimer;
 
-//////////////////////////////////////////////////////////////////////////////
-//						"STRUCTURES" DEFINITIONS							//
-//////////////////////////////////////////////////////////////////////////////
+// Release times of the periodic timers : misses and lateness, read with uC/Probe or the debugger
+PERIODIC heartBeatPeriodic;
+PERIODIC checkerPeriodic;
 
-typedef enum MessageTypes {
-    heartbeat = OFFSET+0,
-    intrusion = OFFSET+1,
-    disarming = OFFSET+2,
-    arming = OFFSET+4,
-    alarmStarted = OFFSET+8,
-    newPassword = OFFSET+24
-} MessageTypes;
+#if APP_CYCLIC_EXEC_EN > 0
+// Cyclic executive : releases of the frame, and its cost (cycles) read with uC/Probe or the debugger
+PERIODIC framePeriodic;
+INT16U frameCycles;
+INT16U frameCyclesMax;
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 //							FUNCTION PROTOTYPES								//
 //////////////////////////////////////////////////////////////////////////////
 static  void  AppStartTask(void *p_arg);
+#if APP_CYCLIC_EXEC_EN > 0
+static  void  FrameTask(void *p_arg);
+#else
 static  void  PasswordManagementTask(void *p_arg);
-static  void  KeyboardTask(void *p_arg);
 static  void  ButtonHandlerTask(void *p_arg);
+#endif
+static  void  AlarmTask(void *p_arg);
 static  void  AppLCDTask(void *p_arg);
 static  void  TimerFunc(void *p_arg);
 static  void  HeartBeatFunc(void *p_arg);
 static  void  CheckerTimerFunc(void *p_arg);
+void restoreState(PERSIST_RECORD* record);
+void alarmStateWrite(unsigned char state);
+void sendMembership(MessageTypes messageid, MEMBER_EVENT event, unsigned int id, unsigned char fromRx);
+static  void  CanRxTask(void *p_arg);
+static void canRxPost(BUFFER_CAN* source);
+#if APP_STATE_BENCH_EN > 0
+static  void  stateBench(void);
+#endif
+#if APP_LCD_BENCH_EN > 0
+static  void  lcdBench(void);
+#endif
+#if APP_DISPLAY_BENCH_EN > 0
+static  void  displayBench(void);
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 //							MAIN FUNCTION									//
@@ -157,20 +216,29 @@ CPU_INT16S  main (void) {
 	OSInit();			// Initialize "uC/OS-II, The Real-Time Kernel"
 
 	init_elec_h_410();
+	OSProbe_TmrInit();	// Timer 3 free running at Fcy (measures, also started by NodeIdInit)
+
+	passwordQ = OSQCreate(&passwordQStorage[0], PASSWORD_Q_SIZE);
+	DisplayInit();
+	alarmQ = OSQCreate(&alarmQStorage[0], ALARM_Q_SIZE);
+
+	NodeIdInit();
+	KeyboardInit(passwordQ);
+	MsgPoolCreate(&canRxPool, canRxStorage, CAN_RX_POOL, sizeof(canRxStorage[0]), (INT8U *)"CAN frames");
+	canRxQ = OSQCreate(canRxQStorage, CAN_RX_Q_SIZE);
+	buttonHold = OSSemCreate(0);
+	ButtonsInit(alarmQ, buttonHold);
+	ZonesInit(alarmQ);
+	AnalogInit(alarmQ);
 
-	myBox = OSMboxCreate((void*)0);
-	lcdBox = OSMboxCreate((void*)0);
+	// Every flag cleared : locked, no timer, no alarm, no password change
+	systemState = OSFlagCreate(0, &err);
+	OSFlagNameSet(systemState, (INT8U *)"System state", &err);
 
-	// Definitions of the mutexes - priorities set arbitarly (and proved empirically not to have a direct influence)
-	heartBeatMutex    		= OSMutexCreate(8, &err);
-	alarmStartedMutex 		= OSMutexCreate(9, &err);
-	flagPasswordChangeMutex = OSMutexCreate(7, &err);
-	flagSystemUnlockedMutex = OSMutexCreate(6, &err);
-	flagTimerActivatedMutex = OSMutexCreate(5, &err);
-	systemProvidedCodeMutex = OSMutexCreate(4, &err);
+	// Definitions of the mutexes - their contention is measured in lockStats (see tools/lockreport.c)
+	heartBeatMutex    		= LockCreate(8, "heartbeat");
+	systemProvidedCodeMutex = LockCreate(4, "password");
 
-	TRISDbits.TRISD12 = 1;	// set pin to input. INTRUSION
-	TRISDbits.TRISD13 = 1;	// set pin to input. CHANGING PASSWORD
 	TRISAbits.TRISA0 = 0;	// set pin to output. BUZZER
 	TRISAbits.TRISA1 = 0;	// set pin to output. SYSTEM STATUS (UN)LOCK
 	TRISAbits.TRISA2 = 0;	// set pin to output. TIMER STATUS (DES)ACTIVATED
@@ -226,42 +294,114 @@ CPU_INT16S  main (void) {
 static  void  AppStartTask (void *p_arg) {
 	INT8U	err;
 	INT16U	i,j;
-
+	PERSIST_RECORD persisted;
+	unsigned char warmStart;
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
 
    (void)p_arg;	// to avoid a warning message
 
     BSP_Init();		// Initialize BSP (Board Support Package) functions
+	#if APP_TRACE_EN > 0
+	TraceInit();
+	#endif
+
+	warmStart = PersistLoad(&persisted);	// State saved before the last reset, if any
 
 	#if OS_TASK_STAT_EN > 0
+	if(warmStart && persisted.idleCtrMax != 0) {
+		// The CPU capacity measured before the reset is still valid, skip the 100ms measurement
+		OS_ENTER_CRITICAL();
+		OSIdleCtrMax = persisted.idleCtrMax;
+		OSStatRdy = OS_TRUE;
+		OS_EXIT_CRITICAL();
+	}
+	else {
     	OSStatInit();	// Determine CPU capacity
+	}
 	#endif
 
     LED_Off(0);		// Turn OFF all the LEDs
 
-	OSTaskCreateExt(PasswordManagementTask,
+	#if APP_STATE_BENCH_EN > 0
+	stateBench();
+	#endif
+
+	// The frames received are handled by this task : it must run before the id claim
+	OSTaskCreateExt(CanRxTask,
 					(void *)0,
-					(OS_STK *)&PasswordManagementTaskStk[0],
-					Password_Management_Task_PRIO,
-					Password_Management_Task_PRIO,
-					(OS_STK *)&PasswordManagementTaskStk[APP_TASK_STK_SIZE-1],
+					(OS_STK *)&CanRxTaskStk[0],
+					Can_Rx_Task_PRIO,
+					Can_Rx_Task_PRIO,
+					(OS_STK *)&CanRxTaskStk[APP_TASK_STK_SIZE-1],
 					APP_TASK_STK_SIZE,
 					(void *)0,
 					OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
 	// defines the App Name (for debug purpose)
-    OSTaskNameSet(Password_Management_Task_PRIO, (CPU_INT08U *)"Password Management Task", &err);
+    OSTaskNameSet(Can_Rx_Task_PRIO, (CPU_INT08U *)"CAN Rx Task", &err);
+
+	// The display is up during the id claim, which tells when no id is free
+	OSTaskCreateExt(AppLCDTask,
+					(void *)0,
+					(OS_STK *)&AppLCDTaskStk[0],
+					APP_TASK_LCD_PRIO,
+					APP_TASK_LCD_PRIO,
+					(OS_STK *)&AppLCDTaskStk[APP_TASK_LCD_STK_SIZE-1],
+					APP_TASK_LCD_STK_SIZE,
+					(void *)0,
+					OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+	// defines the App Name (for debug purpose)
+    OSTaskNameSet(APP_TASK_LCD_PRIO, (CPU_INT08U *)"LCD Task", &err);
+
+	if(warmStart) {
+		restoreState(&persisted);
+	}
 
+	// Claim a node id before anything is sent with it (our previous one if we had one)
+	nodeId[0] = NodeIdClaim(warmStart ? persisted.nodeId : 0);
+	nodeIdentity[0] = nodeId[0];
+	// Enter the group with the view built from the heartbeats heard during the claim
+	MembershipInit(nodeId[0]);
+	sendMembership(memberJoin, MEMBER_JOIN, nodeId[0], 0);
 
-	OSTaskCreateExt(KeyboardTask,
+	OSTaskCreateExt(AlarmTask,
 					(void *)0,
-					(OS_STK *)&KeyboardTaskStk[0],
-					Keyboard_Task_PRIO,
-					Keyboard_Task_PRIO,
-					(OS_STK *)&KeyboardTaskStk[APP_TASK_STK_SIZE-1],
+					(OS_STK *)&AlarmTaskStk[0],
+					Alarm_Task_PRIO,
+					Alarm_Task_PRIO,
+					(OS_STK *)&AlarmTaskStk[APP_TASK_STK_SIZE-1],
 					APP_TASK_STK_SIZE,
 					(void *)0,
 					OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
 	// defines the App Name (for debug purpose)
-	OSTaskNameSet(Keyboard_Task_PRIO, (CPU_INT08U *)"Keyboard Task", &err);
+    OSTaskNameSet(Alarm_Task_PRIO, (CPU_INT08U *)"Alarm Task", &err);
+
+
+	#if APP_CYCLIC_EXEC_EN > 0
+	OSTaskCreateExt(FrameTask,
+					(void *)0,
+					(OS_STK *)&FrameTaskStk[0],
+					Frame_Task_PRIO,
+					Frame_Task_PRIO,
+					(OS_STK *)&FrameTaskStk[APP_TASK_STK_SIZE-1],
+					APP_TASK_STK_SIZE,
+					(void *)0,
+					OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+	// defines the App Name (for debug purpose)
+    OSTaskNameSet(Frame_Task_PRIO, (CPU_INT08U *)"Frame Task", &err);
+	#else
+	OSTaskCreateExt(PasswordManagementTask,
+					(void *)0,
+					(OS_STK *)&PasswordManagementTaskStk[0],
+					Password_Management_Task_PRIO,
+					Password_Management_Task_PRIO,
+					(OS_STK *)&PasswordManagementTaskStk[APP_TASK_STK_SIZE-1],
+					APP_TASK_STK_SIZE,
+					(void *)0,
+					OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+	// defines the App Name (for debug purpose)
+    OSTaskNameSet(Password_Management_Task_PRIO, (CPU_INT08U *)"Password Management Task", &err);
 
 
 	OSTaskCreateExt(ButtonHandlerTask,
@@ -275,28 +415,25 @@ static  void  AppStartTask (void *p_arg) {
 					OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
 	// defines the App Name (for debug purpose)
 	OSTaskNameSet(Button_handler_Task_PRIO, (CPU_INT08U *)"Button handler Task", &err);
+	#endif
 
 
 	heartBeatTimer = OSTmrCreate(0, 5000, OS_TMR_OPT_PERIODIC, HeartBeatFunc, (void*)0, "Heart beat timer", &err);
+	PeriodicInit(&heartBeatPeriodic, 5000);
 	OSTmrStart(heartBeatTimer, &err);
 
 	timerTimer = OSTmrCreate(0, 30000, OS_TMR_OPT_ONE_SHOT, TimerFunc, (void*)0, "intrusion timer", &err);
 
 	HBCheckerTimer = OSTmrCreate(0, 100, OS_TMR_OPT_PERIODIC, CheckerTimerFunc, (void*)0, "Heart beat check", &err); //0.1 seconds timer
+	PeriodicInit(&checkerPeriodic, 100);
 	OSTmrStart(HBCheckerTimer, &err);
 
-
-	OSTaskCreateExt(AppLCDTask,
-					(void *)0,
-					(OS_STK *)&AppLCDTaskStk[0],
-					APP_TASK_LCD_PRIO,
-					APP_TASK_LCD_PRIO,
-					(OS_STK *)&AppLCDTaskStk[APP_TASK_LCD_STK_SIZE-1],
-					APP_TASK_LCD_STK_SIZE,
-					(void *)0,
-					OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
-	// defines the App Name (for debug purpose)
-    OSTaskNameSet(APP_TASK_LCD_PRIO, (CPU_INT08U *)"LCD Task", &err);
+	#if APP_LCD_BENCH_EN > 0
+	lcdBench();
+	#endif
+	#if APP_DISPLAY_BENCH_EN > 0
+	displayBench();
+	#endif
 
 	while(1) {
 		OSTaskSuspend(OS_PRIO_SELF);
@@ -308,16 +445,38 @@ static  void  AppStartTask (void *p_arg) {
 //							COMMON FUNCTIONS								//
 //////////////////////////////////////////////////////////////////////////////
 
-void send(MessageTypes messageid, unsigned char size, unsigned char* message) {
-    transmitBuffer.SID = messageid;
-	transmitBuffer.DLC = size;
+void loadMessage(BUFFER_CAN* buffer, MessageTypes messageid, unsigned long eid, unsigned char extended, unsigned char size, unsigned char* message) {
+	buffer->SID = messageid;
+	buffer->IDE = extended;
+	buffer->SRR = extended;
+	buffer->EID17_6 = (eid >> 6) & 0xFFF;
+	buffer->EID5_0 = eid & 0x3F;
+	buffer->RTR = 0;
+	buffer->DLC = size;
 	unsigned char i;
 	for(i=0; i<size & i<8; i++) {
-		transmitBuffer.DATA[i] = message[i];
+		buffer->DATA[i] = message[i];
 	}
+}
+
+void send(MessageTypes messageid, unsigned char size, unsigned char* message) {
+	while(CAN_TX_PENDING);	// do not overwrite a message not sent yet
+	loadMessage(&transmitBuffer, messageid, 0, 0, size, message);
+	CanSendMessage();
+}
+
+void sendExtended(MessageTypes messageid, unsigned long eid, unsigned char size, unsigned char* message) {
+	while(CAN_TX_PENDING);	// do not overwrite a message not sent yet
+	loadMessage(&transmitBuffer, messageid, eid, 1, size, message);
 	CanSendMessage();
 }
 
+void reply(MessageTypes messageid, unsigned char size, unsigned char* message) {
+	while(CAN_REPLY_PENDING);	// do not overwrite a message not sent yet
+	loadMessage(&replyBuffer, messageid, 0, 0, size, message);
+	CanSendReply();
+}
+
 unsigned char strEqual(char* word1, char* word2) {
 	return (word1[0] == word2[0] & word1[1] == word2[1] & word1[2] == word2[2] & word1[3] == word2[3]);
 }
@@ -336,463 +495,882 @@ void resetPassword(char* code) {
 	}
 }
 
+/*
+ * Sends an arming/disarming message carrying the new configuration generation
+ * so that the receivers stay in line with the generation of the sender.
+*/
+void sendConfigChange(MessageTypes messageid) {
+	unsigned char message[2];
+	configGeneration++;
+	message[0] = nodeId[0];
+	message[1] = configGeneration;
+	send(messageid, 2, message);
+}
+
+/*
+ * Applies a membership event of this node to its view and announces it with
+ * the resulting epoch. From the CAN reception (fromRx), the reply buffer is
+ * used so that a message being sent by another task is not overwritten.
+*/
+void sendMembership(MessageTypes messageid, MEMBER_EVENT event, unsigned int id, unsigned char fromRx) {
+	unsigned char message[MEMBER_EVENT_DLC];
+	unsigned int epoch;
+	LockPend(heartBeatMutex);
+	epoch = MembershipLocalEvent(event, id);
+	LockPost(heartBeatMutex);
+	message[0] = id & 0xFF;
+	message[1] = (id >> 8) & 0xFF;
+	message[2] = epoch & 0xFF;
+	message[3] = (epoch >> 8) & 0xFF;
+	if(fromRx) {
+		reply(messageid, MEMBER_EVENT_DLC, message);
+	}
+	else {
+		send(messageid, MEMBER_EVENT_DLC, message);
+	}
+}
+
+/*
+ * Takes the node out of the group (maintenance) or brings it back. While out,
+ * the node neither sends heartbeats nor evicts the silent members.
+*/
+void toggleMaintenance(void) {
+	if(!membershipLeft) {
+		sendMembership(memberLeave, MEMBER_LEAVE, nodeId[0], 0);
+		membershipLeft = 1;
+		DisplayPost(DISPLAY_STATUS, "Offline", DISPLAY_HIGH);
+	}
+	else {
+		membershipLeft = 0;
+		sendMembership(memberJoin, MEMBER_JOIN, nodeId[0], 0);
+		DisplayPost(DISPLAY_STATUS, "Online", DISPLAY_HIGH);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //						GETTERS-SETTERS FUNCTIONS							//
 // The aim of the following functions is to encapsulate the mutex pendings  //
 // and to make the overall codes elsewhere more readable.                   //
+// The flags live in the 'systemState' event flag group : reading them is a //
+// copy of one word (no mutex, no priority inheritance). They are written   //
+// by the alarm state machine only (alarmStateWrite), which wakes up the    //
+// tasks waiting for a change (systemStateWait).                            //
 //////////////////////////////////////////////////////////////////////////////
 
-void setTheAlarm(unsigned char mode) {
-	// mode is either on=1, off=0
+OS_FLAGS systemStateGet(void) {
 	INT8U err;
-	OSMutexPend(alarmStartedMutex, 0, &err);
-	LATAbits.LATA0 = mode;
-	OSMutexPost(alarmStartedMutex);
+	return OSFlagQuery(systemState, &err);
 }
 
-void flagPasswordChangeSet(unsigned char newValue) {
+/*
+ * Blocks until the flags are set (waitType OS_FLAG_WAIT_SET_xxx) or cleared
+ * (OS_FLAG_WAIT_CLR_xxx), or until the timeout (0 : forever). Returns the flags
+ * which made the task ready, 0 on timeout.
+*/
+OS_FLAGS systemStateWait(OS_FLAGS flags, INT8U waitType, INT16U timeout) {
 	INT8U err;
-	OSMutexPend(flagPasswordChangeMutex, 0, &err);
-	flagPasswordChange = newValue;
-	OSMutexPost(flagPasswordChangeMutex);
+	OS_FLAGS res = OSFlagPend(systemState, flags, waitType, timeout, &err);
+	return (err == OS_ERR_NONE) ? res : 0;
 }
 
 unsigned char flagPasswordChangeGet() {
-	INT8U err;
-	OSMutexPend(flagPasswordChangeMutex, 0, &err);
-	unsigned char res = flagPasswordChange;
-	OSMutexPost(flagPasswordChangeMutex);
-	return res;
-}
-
-void flagSystemUnlockedSet(unsigned char newValue) {
-	INT8U err;
-	OSMutexPend(flagSystemUnlockedMutex, 0, &err);
-	flagSystemUnlocked = newValue;
-	OSMutexPost(flagSystemUnlockedMutex);
+	return (systemStateGet() & STATE_PWD_CHANGE) != 0;
 }
 
 unsigned char flagSystemUnlockedGet() {
-	INT8U err;
-	OSMutexPend(flagSystemUnlockedMutex, 0, &err);
-	unsigned char res = flagSystemUnlocked;
-	OSMutexPost(flagSystemUnlockedMutex);
-	return res;
-}
-
-void flagTimerActivatedSet(unsigned char newValue) {
-	INT8U err;
-	OSMutexPend(flagTimerActivatedMutex, 0, &err);
-	flagTimerActivated = newValue;
-	OSMutexPost(flagTimerActivatedMutex);
+	return (systemStateGet() & STATE_UNLOCKED) != 0;
 }
 
 unsigned char flagTimerActivatedGet() {
-	INT8U err;
-	OSMutexPend(flagTimerActivatedMutex, 0, &err);
-	unsigned char res = flagTimerActivated;
-	OSMutexPost(flagTimerActivatedMutex);
-	return res;
+	return (systemStateGet() & STATE_TIMER) != 0;
 }
 
 void systemProvidedCodeSet(unsigned char *newValue) {
-	INT8U err;
-	OSMutexPend(systemProvidedCodeMutex, 0, &err);
+	LockPend(systemProvidedCodeMutex);
 	stringCopy(systemProvidedCode, newValue);
-	OSMutexPost(systemProvidedCodeMutex);
+	LockPost(systemProvidedCodeMutex);
 }
 
 unsigned char* systemProvidedCodeGet() {
-	INT8U err;
-	OSMutexPend(systemProvidedCodeMutex, 0, &err);
+	LockPend(systemProvidedCodeMutex);
 	unsigned char* res = systemProvidedCode;
-	OSMutexPost(systemProvidedCodeMutex);
+	LockPost(systemProvidedCodeMutex);
 	return res;
 }
 
+#if APP_STATE_BENCH_EN > 0
+/*
+ * Getter cost, in cycles (Fcy) per call, before and after the state word. The
+ * former getter is rebuilt with a mutex of the same priority. Run once, with
+ * the other tasks not created yet, the results are read with uC/Probe or the
+ * debugger.
+*/
+#define STATE_BENCH_CALLS	64
+
+INT16U stateBenchMutexCycles;
+INT16U stateBenchFlagCycles;
+
+static void stateBench(void) {
+	INT8U err;
+	INT16U i, start;
+	volatile unsigned char res;
+	unsigned char flag = 0;
+	OS_EVENT* mutex = OSMutexCreate(5, &err);
+
+	start = TMR3;
+	for(i = 0; i < STATE_BENCH_CALLS; i++) {
+		OSMutexPend(mutex, 0, &err);
+		res = flag;
+		OSMutexPost(mutex);
+	}
+	stateBenchMutexCycles = (INT16U)(TMR3 - start) / STATE_BENCH_CALLS;
+
+	start = TMR3;
+	for(i = 0; i < STATE_BENCH_CALLS; i++) {
+		res = flagSystemUnlockedGet();
+	}
+	stateBenchFlagCycles = (INT16U)(TMR3 - start) / STATE_BENCH_CALLS;
+
+	OSMutexDel(mutex, OS_DEL_ALWAYS, &err);
+}
+#endif
+
+#if APP_LCD_BENCH_EN > 0
+/*
+ * CPU taken by the Timer 1 streaming while both rows are redrawn every
+ * LCD_BENCH_PERIOD ticks, every cell changing : 3200 bytes per second for the
+ * LCD. Before it, each byte cost the LCD task a tick sleep (two context
+ * switches, and at most OS_TICKS_PER_SEC bytes per second) : the cycles per
+ * byte and the bytes per second below are to be compared with that. Run once
+ * the tasks are created ; the results are read with uC/Probe or the debugger.
+*/
+#define LCD_BENCH_PERIOD	10
+#define LCD_BENCH_FRAMES	300
+
+INT8U lcdBenchCpuUsage;			// Peak OSCPUUsage (%)
+INT16U lcdBenchIsrLoad;			// Share of the CPU taken by the interrupt (0.1%)
+INT16U lcdBenchCyclesPerByte;	// Interrupt cycles per byte sent
+INT16U lcdBenchBytesPerSec;		// Bytes sent per second
+
+PERIODIC lcdBenchPeriodic;
+
+static void lcdBench(void) {
+	INT16U i;
+	INT32U start;
+	INT32U elapsed;		// ticks
+#if OS_CRITICAL_METHOD == 3
+	OS_CPU_SR cpu_sr = 0;
+#endif
+	lcdBenchCpuUsage = 0;
+	OS_ENTER_CRITICAL();
+	lcdIsrCycles = 0;
+	lcdIsrBytes = 0;
+	OS_EXIT_CRITICAL();
+	start = OSTimeGet();
+	PeriodicInit(&lcdBenchPeriodic, LCD_BENCH_PERIOD);
+	for(i = 0; i < LCD_BENCH_FRAMES; i++) {
+		DisplayLine(DISPLAY_STATUS, (i & 1) ? "ABCDEFGHIJKLMNOP" : "abcdefghijklmnop");
+		DisplayLine(DISPLAY_INPUT, (i & 1) ? "0123456789ABCDEF" : "FEDCBA9876543210");
+		PeriodicWait(&lcdBenchPeriodic);	// a frame every LCD_BENCH_PERIOD ticks exactly
+		if(OSCPUUsage > lcdBenchCpuUsage) {
+			lcdBenchCpuUsage = OSCPUUsage;
+		}
+	}
+	OS_ENTER_CRITICAL();
+	elapsed = OSTimeGet() - start;
+	lcdBenchIsrLoad = (INT16U)(lcdIsrCycles / (elapsed * (BSP_CPU_ClkFrq() / OS_TICKS_PER_SEC / 1000)));
+	lcdBenchCyclesPerByte = lcdIsrBytes ? (INT16U)(lcdIsrCycles / lcdIsrBytes) : 0;
+	lcdBenchBytesPerSec = (INT16U)(lcdIsrBytes * OS_TICKS_PER_SEC / elapsed);
+	OS_EXIT_CRITICAL();
+	DisplayLine(DISPLAY_STATUS, "");
+	DisplayLine(DISPLAY_INPUT, "");
+}
+#endif
+
+#if APP_DISPLAY_BENCH_EN > 0
+/*
+ * Renders saved by coalescing under a burst of CAN frames : DISPLAY_BENCH_BURST
+ * frames go through the reception path (canRxPost, CanRxTask, actOnRecv), as
+ * the CAN interrupt would post them, DISPLAY_BENCH_PER_TICK per tick (a loaded
+ * bus at 500kbps), so that the LCD task may run in between as it would. The
+ * burst is the password change of another node (the code we already have)
+ * repeated, then an intrusion. Without coalescing, each frame would have been
+ * a render ; the results are read with uC/Probe or the debugger.
+*/
+#define DISPLAY_BENCH_BURST		32
+#define DISPLAY_BENCH_PER_TICK	4
+
+INT32U displayBenchFrames;		// Frames of the burst handled by CanRxTask
+INT32U displayBenchDropped;		// ... dropped because canRxPool was empty
+INT32U displayBenchUpdates;		// Changes of the frame they caused
+INT32U displayBenchRenders;		// Render passes they cost
+
+static void displayBench(void) {
+	INT32U updates = displayUpdates;
+	INT32U renders = displayRenders;
+	INT32U exhausted = canRxPool.exhausted;
+	BUFFER_CAN frame;
+	INT16U i;
+	unsigned char j;
+	for(i = 0; i < DISPLAY_BENCH_BURST; i++) {
+		memset(&frame, 0, sizeof(frame));
+		if(i < DISPLAY_BENCH_BURST - 1) {
+			frame.SID = newPassword;
+			frame.DLC = PWDSIZE+2;
+			for(j = 0; j <= PWDSIZE; j++) {
+				frame.DATA[j] = nodeIdentity[j];
+			}
+			frame.DATA[PWDSIZE+1] = passwordGeneration;
+		}
+		else {
+			frame.SID = intrusion;
+			frame.DLC = 3;
+			frame.DATA[0] = nodeId[0];
+		}
+		canRxPost(&frame);
+		if((i % DISPLAY_BENCH_PER_TICK) == DISPLAY_BENCH_PER_TICK - 1) {
+			OSTimeDly(1);
+		}
+	}
+	OSTimeDly(100);		// CanRxTask handles the rest, the LCD task renders
+	displayBenchDropped = canRxPool.exhausted - exhausted;
+	displayBenchFrames = DISPLAY_BENCH_BURST - displayBenchDropped;
+	displayBenchUpdates = displayUpdates - updates;
+	displayBenchRenders = displayRenders - renders;
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+//						PERSISTENCE FUNCTIONS								//
+// The state needed to resume protecting the zone after a reset (brownout,  //
+// watchdog...) is kept in the program flash (see Persist.c).               //
+//////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Saves the current state if it changed since the last call. Called
+ * periodically, the flash being written only on actual changes.
+*/
+void persistState(void) {
+	PERSIST_RECORD record;
+	record.nodeId = nodeId[0];
+	record.state = systemStateGet() & (STATE_UNLOCKED | STATE_ALARM);
+	record.configGeneration = configGeneration;
+	record.passwordGeneration = passwordGeneration;
+	stringCopy(record.password, systemProvidedCodeGet());
+	record.idleCtrMax = OSIdleCtrMax;
+	PersistSave(&record);
+}
+
+/*
+ * Puts the node back in the state it had before the reset. The heartbeats of
+ * the other nodes then bring it up to date if something changed meanwhile.
+*/
+void restoreState(PERSIST_RECORD* record) {
+	configGeneration = record->configGeneration;
+	passwordGeneration = record->passwordGeneration;
+	systemProvidedCodeSet(record->password);
+	if(record->state & HB_STATE_UNLOCKED) {
+		alarmStateWrite(ALARM_DISARMED);
+		DisplayPost(DISPLAY_STATUS, "Unlocked", DISPLAY_HIGH);
+	}
+	else {
+		alarmStateWrite((record->state & HB_STATE_ALARM) ? ALARM_ALARMING : ALARM_ARMED);
+		DisplayPost(DISPLAY_STATUS, "Locked", DISPLAY_HIGH);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //						TASKS & TIMERS FUNCTIONS							//
 //////////////////////////////////////////////////////////////////////////////
 
 /*
- * The function has for aim to encapsulate the routine used each time the system
- * is UNLOCKED. This typically involves displaying on the LCD, desactivating the
- * buzzer, updating the flags and communicating the action if relevant. (doSend)
+ * Queues an event for the alarm state machine. Every input goes through here :
+ * keypad codes, buttons, CAN messages and timers (tasks, timer callbacks and
+ * CAN reception alike).
 */
-void LockedSystemActOnCorrectPassword(unsigned char doSend) {
+void alarmPost(unsigned char event) {
+	TRACE_EVENT_ADD(TRACE_Q_POST, alarmQ, event);
+	OSQPost(alarmQ, (void*)(INT16U)event);
+}
+
+/*
+ * Writes the alarm state and its outputs : the state word (new bits set before
+ * the old ones are cleared, so that no reader sees a state with neither), the
+ * buzzer and the LEDs.
+*/
+void alarmStateWrite(unsigned char state) {
 	INT8U err;
-	int i;
-    // Switch the system to the 'unlocked system' state
-    flagSystemUnlockedSet(1);
-	OSMboxPost(lcdBox, "Unlocked");
-    // System unlocked
-    LATAbits.LATA1 = 1;
-    // Buzzer desactivated !
-    setTheAlarm(0);
-    // timer desactivated !
-	OSTmrStop(timerTimer, OS_TMR_OPT_NONE, (void*)0, &err);
-	// Communicate to other nodes
-	if(doSend) {
-		send(disarming, 1, nodeId);
-	}
-	LATAbits.LATA2 = 0;
-	flagTimerActivatedSet(0);
-	TASK_ENABLE2 = 0;
-	OSMutexPend(heartBeatMutex, 0, &err);
-	//Reset Heart Beat Counters
-	for(i=0;i<NUMBER_NODES;i++){
-		HBCounter[i]=0;
-	}
-	OSMutexPost(heartBeatMutex);
+	OS_FLAGS flags = AlarmStateFlags(state);
+	OS_FLAGS changed = flags ^ AlarmStateFlags(alarmState);
+	alarmState = state;
+	if(changed & STATE_PWD_CHANGE) {
+		OSQPost(passwordQ, &passwordModeChanged);	// wakes up the password task
+	}
+	OSFlagPost(systemState, flags, OS_FLAG_SET, &err);
+	OSFlagPost(systemState, HB_STATE_ALARM_MASK & ~flags, OS_FLAG_CLR, &err);
+	LATAbits.LATA0 = (flags & STATE_ALARM) != 0;		// Buzzer
+	LATAbits.LATA1 = (flags & STATE_UNLOCKED) != 0;		// System (un)locked
+	LATAbits.LATA2 = (flags & STATE_TIMER) != 0;		// Intrusion timer running
 }
 
 /*
- * The function has for aim to encapsulate the routine used each time the system
- * is LOCKED. This typically involves displaying on the LCD, updating the flags
- * and communicating the action if relevant. (doSend)
+ * Performs the action of a transition (the outputs of the new state being
+ * already written) : displaying on the LCD, (re)starting or stopping the
+ * intrusion timer and communicating the change to the other nodes.
 */
-void UnlockedSystemActOnCorrectPassword(unsigned char doSend) {
+void alarmAct(unsigned char action) {
 	INT8U err;
-    // Switch the to the 'locked system' state
-    flagSystemUnlockedSet(0);
-	OSMboxPost(lcdBox, "Locked");
-    // System locked
-	if(doSend) {
-		send(arming, 1, nodeId);
+	unsigned char frame[3];
+	switch(action) {
+		case(ACT_WRONG_CODE):
+			DisplayLine(DISPLAY_STATUS, "Wrong pwd");
+			break;
+		case(ACT_ARM_SEND):
+			sendConfigChange(arming);
+			// no break : the rest is the same as being armed by another node
+		case(ACT_ARM):
+			DisplayPost(DISPLAY_STATUS, "Locked", DISPLAY_HIGH);
+			// An armed node must be monitored : back in the group if it was out for maintenance
+			if(membershipLeft) {
+				toggleMaintenance();
+			}
+			break;
+		case(ACT_DISARM_SEND):
+			#if APP_PWD_BENCH_EN > 0
+			pwdBenchLatency = (BSP_CycleTmrRd() - pwdBenchCodeTime) / (BSP_CPU_ClkFrq() / 1000000L);
+			if(pwdBenchLatency > pwdBenchLatencyMax) {
+				pwdBenchLatencyMax = pwdBenchLatency;
+			}
+			#endif
+			sendConfigChange(disarming);
+			// no break : the rest is the same as being disarmed by another node
+		case(ACT_DISARM):
+			OSTmrStop(timerTimer, OS_TMR_OPT_NONE, (void*)0, &err);
+			ZonesClear();
+			AnalogClear();
+			DisplayPost(DISPLAY_STATUS, "Unlocked", DISPLAY_HIGH);
+			TASK_ENABLE2 = 0;
+			break;
+		case(ACT_ENTRY):
+			#if APP_BUTTON_BENCH_EN > 0
+			buttonBenchCycles = TMR3 - buttonEdgeCapture[BUTTON_INTRUSION];	// valid below 1.6ms (TMR3 wraps)
+			if(buttonBenchCycles > buttonBenchCyclesMax) {
+				buttonBenchCyclesMax = buttonBenchCycles;
+			}
+			#endif
+			frame[0] = nodeId[0];
+			frame[1] = ZonesTripped();
+			frame[2] = AnalogTripped();
+			send(intrusion, 3, frame);
+			OSTmrStart(timerTimer, &err);
+			break;
+		case(ACT_ZONE_ALARM):
+			frame[0] = nodeId[0];
+			frame[1] = ZonesTripped();
+			frame[2] = AnalogTripped();
+			send(intrusion, 3, frame);
+			// no break : the alarm starts at once
+		case(ACT_ALARM_SEND):
+			#if APP_TRACE_EN > 0
+			TraceTrigger();	// the ring keeps what led to the alarm and what followed
+			#endif
+			send(alarmStarted, 1, nodeId);
+			break;
+		case(ACT_SHOW_LOST):
+			DisplayPost(DISPLAY_STATUS, "Node lost", DISPLAY_HIGH);
+			break;
 	}
-	// Show that the system is locked
-    LATAbits.LATA1 = 0;
 }
 
 /*
- * The function is in charge of comparing the code provided in parameter with
- * the one present in memory. If the code matches the one in memory, an action
- * is performed depending on the system state (locked or unlocked). Otherwise,
- * a warning message is displayed on the LCD.
+ * The alarm state machine (see the transition table in Alarm.c). This task is
+ * the only one changing the state : each event is handled with one look-up in
+ * the table and at most one state write, then the action of the transition.
 */
-void checkPasswordValidity(char* userProvidedCode, INT8U* err) {
-	userProvidedCode = OSMboxPend(myBox, 50, err);
-	if(*err == OS_ERR_NONE) {
-       if(strEqual(userProvidedCode, systemProvidedCodeGet())) {
-           if(!flagSystemUnlockedGet()) {
-               LockedSystemActOnCorrectPassword(1);
-           }
-           else {
-               UnlockedSystemActOnCorrectPassword(1);
-           }
-       }
-		else {
-			OSMboxPost(lcdBox, "Wrong pwd");
+static void AlarmTask(void *p_arg) {
+	INT8U err;
+	unsigned char event;
+	ALARM_TRANSITION transition;
+	(void)p_arg;
+	while(1) {
+		event = (unsigned char)(INT16U)OSQPend(alarmQ, 0, &err);
+		TRACE_EVENT_ADD(TRACE_Q_GET, alarmQ, event);
+		transition = AlarmTransition(alarmState, event);
+		if(transition.next != alarmState) {
+			alarmStateWrite(transition.next);
 		}
+		alarmAct(transition.action);
 	}
 }
 
+/*
+ * The function is in charge of comparing the code provided in parameter with
+ * the one present in memory. Whether a correct code locks or unlocks the
+ * system depends on its state : this is up to the state machine.
+*/
+void checkPasswordValidity(char* userProvidedCode) {
+	alarmPost(strEqual(userProvidedCode, systemProvidedCodeGet()) ? EV_CODE_OK : EV_CODE_WRONG);
+}
+
 /*
  * The function is in charge of comparing and replacing the system password if
  * the procedur is respected (entering the old password onece and entering the
  * new one twice). Otherwise, the procedure continue but the user is warned
  * though the LCD of the system and procedure state.
+ * It handles one code of the procedure and returns the next step.
 */
-void changePasswordProcedure(char* userProvidedCode, char* userProvidedCodeConfirmation, INT8U* err) {
-	char aux1[PWDSIZE]; // temporary string used for comparisons
-	char aux2[PWDSIZE]; // temporary string used for comparisons
-	OSMboxPost(lcdBox, "Enter old pwd");
-	userProvidedCode = OSMboxPend(myBox, 0, err); // blocking instruction
-	if(*err == OS_ERR_NONE) {
-		if(strEqual(userProvidedCode, systemProvidedCodeGet())) {
-			OSMboxPost(lcdBox, "Enter new pwd");
-			userProvidedCode = OSMboxPend(myBox, 0, err); // blocking instruction
-			stringCopy(aux1, userProvidedCode);
-			OSMboxPost(lcdBox, "Confirm new pwd");
-			userProvidedCodeConfirmation = OSMboxPend(myBox, 0, err); // blocking instruction
-			stringCopy(aux2, userProvidedCodeConfirmation);
-			if(strEqual(aux1, aux2)) {
-				// put the system password to userProvidedCode
-				systemProvidedCodeSet(aux1);
-				send(newPassword, 5, nodeIdentity);
-				OSMboxPost(lcdBox, "New pwd set");
-				flagPasswordChangeSet(0);
+unsigned char changePasswordStep(unsigned char step, char* userProvidedCode, char* newCode) {
+	char newPasswordMessage[PWDSIZE+2]; // node id, password and password generation
+	switch(step) {
+		case(PWD_STEP_OLD):
+			if(!strEqual(userProvidedCode, systemProvidedCodeGet())) {
+				DisplayLine(DISPLAY_STATUS, "Wrong pwd");
+				return PWD_STEP_OLD;	// keep the system in unlock mode
+			}
+			DisplayLine(DISPLAY_STATUS, "Enter new pwd");
+			return PWD_STEP_NEW;
+		case(PWD_STEP_NEW):
+			stringCopy(newCode, userProvidedCode);
+			DisplayLine(DISPLAY_STATUS, "Confirm new pwd");
+			return PWD_STEP_CONFIRM;
+		case(PWD_STEP_CONFIRM):
+			if(strEqual(newCode, userProvidedCode)) {
+				// put the system password to the new code
+				systemProvidedCodeSet(newCode);
+				passwordGeneration++;
+				stringCopy(newPasswordMessage, nodeIdentity);
+				newPasswordMessage[PWDSIZE] = nodeIdentity[PWDSIZE];
+				newPasswordMessage[PWDSIZE+1] = passwordGeneration;
+				send(newPassword, PWDSIZE+2, newPasswordMessage);
+				DisplayPost(DISPLAY_STATUS, "New pwd set", DISPLAY_HIGH);
 			}
 			else {
-				// password change fail
-				OSMboxPost(lcdBox, "FAIL - unlock");
-				flagPasswordChangeSet(0);
-				// keep the system in unlock mode
+				// password change fail, keep the system in unlock mode
+				DisplayLine(DISPLAY_STATUS, "FAIL - unlock");
 			}
-		}
-		else {
-			OSMboxPost(lcdBox, "Wrong pwd");
-			// keep the system in unlock mode
-		}
+			alarmPost(EV_PWD_CHANGE_DONE);
+			return PWD_STEP_CHECK;
 	}
+	return PWD_STEP_CHECK;
 }
 
 /*
- * The function is in charge of managing the password entered by the user
- * password is obtained in the functions called by this function. The function
- * called is determined by the system state (locked or unlocked).
+ * Shows the code being typed on the input line : only the digit just typed
+ * differs from what the LCD shows, so only that cell is written.
 */
-static  void PasswordManagementTask (void *p_arg) {
-	(void)p_arg;			// to avoid a warning message
-	LATAbits.LATA5 = 1;
-	INT8U err;
-	char* userProvidedCode;
-	char* userProvidedCodeConfirmation;
-    while(1) {
-		if(!flagPasswordChangeGet()) {
-			checkPasswordValidity(userProvidedCode, &err);
+void echoCode(char* code) {
+	DisplayText(DISPLAY_INPUT, 0, code, PWDSIZE);
+}
+
+// Code being typed, and step of the password change procedure (see passwordHandle)
+static char pwdCode[PWDSIZE] = {STARCHAR, STARCHAR, STARCHAR, STARCHAR};
+static unsigned char pwdDigits = 0;
+static char pwdNewCode[PWDSIZE];
+static unsigned char pwdStep = PWD_STEP_CHECK;
+
+/*
+ * Handles one message of passwordQ : a keypad event (queued by the keyboard
+ * driver, so that keys typed ahead are never lost), or the password change
+ * mode entered or left (posted by alarmStateWrite). The keys are collected
+ * four by four and echoed on the LCD ; a complete code is then checked at
+ * once, or handled by the current step of the password change procedure.
+*/
+static void passwordHandle(void* msg) {
+	KEY_EVENT* event;
+	if(msg == &passwordModeChanged) {
+		resetPassword(pwdCode);	// a code being typed is dropped
+		pwdDigits = 0;
+		echoCode(pwdCode);
+		if(flagPasswordChangeGet()) {
+			DisplayLine(DISPLAY_STATUS, "Enter old pwd");
+			pwdStep = PWD_STEP_OLD;
 		}
 		else {
-			changePasswordProcedure(userProvidedCode, userProvidedCodeConfirmation, &err);
+			pwdStep = PWD_STEP_CHECK;	// left (done, or armed by another node)
 		}
-		OSTimeDly(Password_Management_Task_PERIOD);
-    }
+		return;
+	}
+	event = (KEY_EVENT*)msg;
+	if(event->type == KEY_PRESS) {		// a held key does not type again (KEY_REPEAT ignored)
+		TASK_ENABLE4 = 1;
+		pwdCode[pwdDigits++] = hex2ASCII[event->key];
+		echoCode(pwdCode);
+		if(pwdDigits == PWDSIZE) {
+			#if APP_PWD_BENCH_EN > 0
+			pwdBenchCodeTime = event->time;
+			#endif
+			if(pwdStep == PWD_STEP_CHECK) {
+				checkPasswordValidity(pwdCode);
+			}
+			else {
+				pwdStep = changePasswordStep(pwdStep, pwdCode, pwdNewCode);
+			}
+			resetPassword(pwdCode);
+			pwdDigits = 0;
+			echoCode(pwdCode);
+		}
+		TASK_ENABLE4 = 0;
+	}
+	MsgFree(event);
 }
 
 /*
- * This function is defined has the callback function of the intrusion timer. It
- * typically looks why the timer has stopped. In case of time out, the system
- * unlock flag is set to False, and we activate the buzzer. Otherwise, we simply
- * set the timer flag to false.
+ * If the system is unlocked, the node leaves the group (or comes back) : the
+ * intrusion button has been held for 3s.
 */
-static void TimerFunc(void *p_arg) {
-	if(!flagSystemUnlockedGet()) {
-        // Buzzer activated !
-        setTheAlarm(1);
-		send(alarmStarted, 1, nodeId);
-    }
-	else{
-		flagTimerActivatedSet(0);
+static void buttonHoldHandle(void) {
+	TASK_ENABLE3 = 1;
+	if(flagSystemUnlockedGet()) {
+		toggleMaintenance();
 	}
-	LATAbits.LATA2 = 0;
+	TASK_ENABLE3 = 0;
 }
 
+#if APP_CYCLIC_EXEC_EN > 0
 /*
- * This function is in charge of pooling on the buttons and to ignore some user
- * inputs given the system states (e.g. the intrusion button is ignored is the
- * timer is already on).
+ * Cyclic executive : the keypad, the button and the password are the steps of
+ * a single frame, released every APP_CYCLIC_FRAME_TICKS, always in the same
+ * order. The keypad is scanned first so that a key debounced in this frame is
+ * typed in this frame as well. Nothing pends : what the ISRs and the other
+ * tasks posted meanwhile is taken with the Accept calls.
 */
-static void ButtonHandlerTask(void *p_arg) {
-	INT8U err;
+static void FrameTask(void *p_arg) {
 	(void)p_arg;
+	INT8U err;
+	void* msg;
+	INT16U start;
+	LATAbits.LATA5 = 1;
+	PeriodicInit(&framePeriodic, APP_CYCLIC_FRAME_TICKS);
 	while(1) {
-		TASK_ENABLE3 = 1;
-		if(!PORTDbits.RD12 & !flagTimerActivatedGet() & !flagSystemUnlockedGet()) {
-			LATAbits.LATA2 = 1;
-			OSTmrStart(timerTimer, &err);
-			flagTimerActivatedSet(1);
-			send(intrusion, 1, nodeId);
+		start = TMR3;
+		KeyboardPoll();								// 1) keypad scan, events to passwordQ
+		if(OSSemAccept(buttonHold)) {				// 2) button handling
+			buttonHoldHandle();
+		}
+		while(1) {									// 3) password processing
+			msg = OSQAccept(passwordQ, &err);
+			if(msg == (void*)0) {
+				break;
+			}
+			TRACE_EVENT_ADD(TRACE_Q_GET, passwordQ, msg);
+			passwordHandle(msg);
 		}
-		if(!PORTDbits.RD13 & flagSystemUnlockedGet()) {
-			flagPasswordChangeSet(1);
+		frameCycles = TMR3 - start;	// valid below 1.6ms (TMR3 wraps)
+		if(frameCycles > frameCyclesMax) {
+			frameCyclesMax = frameCycles;
 		}
-		TASK_ENABLE3 = 0;
-		OSTimeDly(Button_handler_Task_PERIOD);
+		PeriodicWait(&framePeriodic);
 	}
 }
-
+#else
 /*
- * This function is in charge of reading the keyboard entries, it collects them
- * four by four. Once four chars have been received, it sends them to the task
- * in charge of the password management. In addition, this task also manage the
- * display of the code onto the screen.
+ * The function is in charge of managing the password entered by the user. It
+ * sleeps until something is posted to passwordQ (see passwordHandle).
 */
-static  void  KeyboardTask (void *p_arg) {
+static  void PasswordManagementTask (void *p_arg) {
 	(void)p_arg;			// to avoid a warning message
-	KeyboardInit();
+	LATAbits.LATA5 = 1;
+	INT8U err;
+	void* msg;
+    while(1) {
+		msg = OSQPend(passwordQ, 0, &err);	// blocking instruction, no timeout
+		#if APP_PWD_BENCH_EN > 0
+		pwdBenchWakeups++;
+		#endif
+		if(err != OS_ERR_NONE) {
+			continue;
+		}
+		TRACE_EVENT_ADD(TRACE_Q_GET, passwordQ, msg);
+		passwordHandle(msg);
+    }
+}
+#endif
 
-	INT8U key1 = 0;
-	INT8U key2 = 0;
-	INT8U key3;
-	char code[PWDSIZE] = {STARCHAR, STARCHAR, STARCHAR, STARCHAR};
-    unsigned char i;
+/*
+ * This function is defined has the callback function of the intrusion timer. The
+ * time out is an event of the state machine : it raises the alarm if the code
+ * has not been entered meanwhile.
+*/
+static void TimerFunc(void *p_arg) {
+	(void)p_arg;
+	alarmPost(EV_ENTRY_TIMEOUT);
+}
 
-    while(1) {
-		TASK_ENABLE4 = 1;
-		i = 0;
-        while(i<PWDSIZE) {
-			key3 = key2;
-			key2 = key1;
-			key1 = KeyboardScan();
-			if ((key1 == key2) && (key1 != key3) && (key1 != 255)) {
-				code[i] = hex2ASCII[key1];
-				stringCopy(lcdpmsg, code);
-				OSMboxPost(lcdBox, lcdpmsg);
-				i++;
-			}
-			TASK_ENABLE4 = 0;
-			OSTimeDly(Keyboard_Task_PERIOD);
-			TASK_ENABLE4 = 1;
-        }
-		stringCopy(pmsg, code);
-		stringCopy(lcdpmsg, code);
-        OSMboxPost(myBox, pmsg);
-		OSMboxPost(lcdBox, lcdpmsg);
-		resetPassword(code);
-		TASK_ENABLE4 = 0;
-		OSTimeDly(Keyboard_Task_PERIOD);
+#if APP_CYCLIC_EXEC_EN == 0
+/*
+ * The presses themselves never reach this task : the button driver posts them
+ * straight to the state machine from its interrupts (see Buttons.c), so that
+ * an intrusion goes out as soon as the alarm task runs. This task only sleeps
+ * until the intrusion button has been held for 3s ; if the system is unlocked,
+ * the node then leaves the group (or comes back).
+*/
+static void ButtonHandlerTask(void *p_arg) {
+	INT8U err;
+	(void)p_arg;
+	while(1) {
+		OSSemPend(buttonHold, 0, &err);
+		buttonHoldHandle();
 	}
 }
+#endif
 
 /*
  * Simple callback function called periodically by the timer in charge of the
  * heartbeat. Tjis simply consists in making the led 7 blink and send a message
- * to the other nodes.
+ * to the other nodes. The message carries the state of the node (flags, buzzer,
+ * generations, membership epoch and CAN error summary) so that the other nodes
+ * can keep their status table up to date without any additional message.
 */
 static void HeartBeatFunc(void *p_arg) {
 	(void)p_arg;
+	NODE_STATUS status;
+	unsigned char payload[HB_DLC];
+	PeriodicRelease(&heartBeatPeriodic);
 	LATAbits.LATA7 = !LATAbits.LATA7;
-	send(heartbeat, 1, nodeId);
+	if(membershipLeft) {
+		return;	// out of the group, the other nodes do not expect us
+	}
+	status.state = systemStateGet() & HB_STATE_ALARM_MASK;	// the state word uses the heartbeat bits
+	if(C1INTFbits.EWARN)		status.state |= HB_STATE_ERR_WARNING;
+	if(C1INTFbits.TXBP | C1INTFbits.RXBP)	status.state |= HB_STATE_ERR_PASSIVE;
+	if(C1INTFbits.TXBO)			status.state |= HB_STATE_BUS_OFF;
+	status.configGeneration = configGeneration;
+	status.passwordGeneration = passwordGeneration;
+	status.errors = HeartBeatErrorSummary(C1ECbits.TERRCNT, C1ECbits.RERRCNT);
+	status.epoch = membershipEpoch;
+	HeartBeatEncode(payload, nodeId[0], &status);
+	send(heartbeat, HB_DLC, payload);
 }
 
 /*
- * This task simply receives every messages contained in its mailbox and display
- * them onto the LCD.
+ * This function is called for each heartbeat carrying a state. If the sender
+ * has seen a more recent arming/disarming than us (i.e. we missed the message),
+ * we silently apply its state. If we agree on the configuration and the sender
+ * is ringing, we ring as well if we are locked (missed 'alarmStarted').
 */
-static  void  AppLCDTask (void *p_arg) {
-	INT8U err;
-	INT8U* key;
+void heartBeatConverge(NODE_STATUS* peer) {
+	if(generationNewer(peer->configGeneration, configGeneration)) {
+		configGeneration = peer->configGeneration;
+		alarmPost((peer->state & HB_STATE_UNLOCKED) ? EV_REMOTE_DISARM : EV_REMOTE_ARM);
+	}
+	else if(peer->configGeneration == configGeneration && (peer->state & HB_STATE_ALARM)) {
+		alarmPost(EV_REMOTE_ALARM);
+	}
+}
 
+/*
+ * This task keeps the LCD up to date with the frame written by the other tasks
+ * (see Display.c) : it sleeps until the frame changes, then writes the cells
+ * which differ. Changes made while it renders are taken by the next pass.
+*/
+static  void  AppLCDTask (void *p_arg) {
    (void)p_arg;			// to avoid a warning message
 
-	DispInit(2, 16);	// Initialize uC/LCD for a 2 row by 16 column display
-	DispClrScr();		// Clear the screen
-	INT8U row = 0;			// initialise the cursor position
-	INT8U line = 0;
+	DispInit(DISPLAY_ROWS, DISPLAY_COLS);	// Initialize uC/LCD for a 2 row by 16 column display
+	DispClrScr();		// Clear the screen : blank, as the shadow of Display.c
+	LcdInit();			// From now on, the bytes are streamed by the Timer 1 interrupt
 
 	while(1) {
+		DisplayWait();
 		TASK_ENABLE5 = 1;
-		key = OSMboxPend(lcdBox, 0, &err);
-		DispClrScr();
-		DispStr(line, row, key);
+		DisplayRender();
 		TASK_ENABLE5 = 0;
 	}
 }
 
 /*
  * This function is a routine that is called every 100ms. This aim is to manage
- * the counters of every heartbeat. In fact, this allow us to emulate multiple
- * timer with only one. Therefore, if the associated heartbeat is said to be
- * active (HBflag[i]==1), the counters are compared with 50. If bigger, then it
- * means that no heartbeat has been received whitin 5s, so the alarm is rised.
- * Otherwise, the counter is incremented.
- * In addition, this routine is coupled with another one that simply determines
- * after the 5 first seconds of the system which is its node id. This is done
- * by checking the HBflag and picking the first index for which the value is 0.
+ * the counters of every member. In fact, this allow us to emulate multiple
+ * timer with only one. A member whose heartbeat has not been received whitin
+ * 5s is evicted from the group (and every node is told so). As it did not
+ * leave on purpose, the alarm is rised if the system is locked.
+ * The node id itself is claimed at start-up (see NodeIdClaim).
 */
 static void CheckerTimerFunc(void *p_arg){
 	(void)p_arg;
-	int i;
-	INT8U err;
+	unsigned int id = 0;
+	PeriodicRelease(&checkerPeriodic);
 	TASK_ENABLE1 = 1;
-	//Increment all the counters except ours
-	if(!flagSystemUnlockedGet()){
-		OSMutexPend(heartBeatMutex, 0, &err);
-		for(i = 0;i < NUMBER_NODES; i++){
-			if(HBflags[i]) {
-				if (HBCounter[i]>=50){
-					// Buzzer activated !
-		   			setTheAlarm(1);
-					// TODO set flag to zero in order to free the flag
-				}
-				else{
-					HBCounter[i]++;
-				}
-			}
-		}
-		HBCounter[nodeId[0]]=0;
-		err = OSMutexPost(heartBeatMutex);
-		// Determine the node id
-		if(IDcounter = 50) {
-			// TODO what to do when every counters are at 1 (no free flag)
-			unsigned char i = 0;
-			unsigned char found = 0; // used as a boolean
-			while(i < NUMBER_NODES && !found) {
-				if(!HBflags[i]) { // HBflags[i] == 0
-					nodeId[0] = i;
-					nodeIdentity[0] = i;
-					found = 1;
-					IDcounter = 0;
-					HBflags[i] = 1;
-				}
-				i++;
-			}
-		}
-		else {
-			IDcounter++;
+	LockPend(heartBeatMutex);
+	MembershipTick();
+	LockPost(heartBeatMutex);
+	while(!membershipLeft) {
+		LockPend(heartBeatMutex);
+		id = MembershipExpired(id);
+		LockPost(heartBeatMutex);
+		if(id == MEMBER_NONE) {
+			break;
 		}
+		sendMembership(memberEvict, MEMBER_EVICT, id, 0);
+		alarmPost(EV_MEMBER_LOST);
+		id++;
 	}
+	persistState();
 	TASK_ENABLE1 = 0;
 }
 
 /*
- * This function is called by the can interrrupt and is in charge of managing the
+ * This function is called by CanRxTask and is in charge of managing the
  * incomming messages depending on their SID.
 */
-void actOnRecv(unsigned char offset) {
-	INT8U err;
+void actOnRecv(BUFFER_CAN* frame) {
 	unsigned char i;
-	switch(receiveBuffers[offset].SID) {
+	unsigned char rejoin = 0;
+	unsigned int id;
+	unsigned int epoch;
+	NODE_STATUS peer;
+	switch(frame->SID) {
 		case(heartbeat):
 			//detect from which node 0-9 excluding ours
-			OSMutexPend(heartBeatMutex, 0, &err);
-			unsigned char index = receiveBuffers[offset].DATA[0];
-			if(index < 10) {
-				HBflags[index] = 1;		// 'Activate' a flag
-				HBCounter[index] = 0;	// Reset Counter with ID
+			LockPend(heartBeatMutex);
+			unsigned int index = HeartBeatStore(frame->DATA, frame->DLC);
+			if(index != HB_INVALID_ID) {
+				// Heartbeats without a state (older nodes) are taken as coming from our view
+				epoch = (frame->DLC >= HB_DLC) ? nodeStatus[index].epoch : membershipEpoch;
+				rejoin = MembershipHeard(index, epoch);
+				peer = nodeStatus[index];
 				LATAbits.LATA3 = !LATAbits.LATA3;
 			}
-			OSMutexPost(heartBeatMutex);
+			LockPost(heartBeatMutex);
+			if(rejoin && !membershipLeft) {
+				// We missed membership events : enter the more recent view
+				sendMembership(memberJoin, MEMBER_JOIN, nodeId[0], 1);
+			}
+			if(index != HB_INVALID_ID && frame->DLC >= HB_DLC) {
+				heartBeatConverge(&peer);
+			}
 			break;
 		case(intrusion):
 			// No need to care about this message
-			OSMboxPost(lcdBox, "Intrusion!");
+			DisplayPost(DISPLAY_STATUS, "Intrusion!", DISPLAY_ALERT);
 			break;
 		case(disarming):
-			LockedSystemActOnCorrectPassword(0);
+			if(frame->DLC >= 2) {
+				configGeneration = frame->DATA[1];
+			}
+			alarmPost(EV_REMOTE_DISARM);
 			break;
 		case(arming):
-			UnlockedSystemActOnCorrectPassword(0);
+			if(frame->DLC >= 2) {
+				configGeneration = frame->DATA[1];
+			}
+			alarmPost(EV_REMOTE_ARM);
 			break;
 		case(alarmStarted):
-			// Assumption : all nodes are locked
-			setTheAlarm(1);
+			// Ignored by the state machine if we are not locked
+			alarmPost(EV_REMOTE_ALARM);
 			break;
 		case(newPassword):
-			OSMboxPost(lcdBox, "New pwd set");
-			systemProvidedCodeSet(&receiveBuffers[offset].DATA[1]);
+			DisplayPost(DISPLAY_STATUS, "New pwd set", DISPLAY_HIGH);
+			systemProvidedCodeSet(&frame->DATA[1]);
+			if(frame->DLC >= PWDSIZE+2) {
+				passwordGeneration = frame->DATA[PWDSIZE+1];
+			}
 			break;
+		case(idClaim):
+			NodeIdOnClaim(frame);
+			break;
+		case(idAck):
+			NodeIdOnAck(frame);
+			break;
+		case(memberJoin):
+		case(memberLeave):
+		case(memberEvict):
+			if(frame->DLC < MEMBER_EVENT_DLC) {
+				break;
+			}
+			id = frame->DATA[0] | ((unsigned int)frame->DATA[1] << 8);
+			epoch = frame->DATA[2] | ((unsigned int)frame->DATA[3] << 8);
+			if(id == nodeId[0]) {
+				if(frame->SID == memberEvict && !membershipLeft) {
+					// Evicted while alive (lost heartbeats) : announce ourselves again
+					sendMembership(memberJoin, MEMBER_JOIN, nodeId[0], 1);
+				}
+				break;
+			}
+			LockPend(heartBeatMutex);
+			if(frame->SID == memberJoin) {
+				MembershipApply(MEMBER_JOIN, id, epoch);
+			}
+			else if(frame->SID == memberLeave) {
+				MembershipApply(MEMBER_LEAVE, id, epoch);
+			}
+			else {
+				rejoin = MembershipApply(MEMBER_EVICT, id, epoch);
+			}
+			LockPost(heartBeatMutex);
+			if(rejoin) {
+				// A member was lost without leaving : same as a missing heartbeat
+				alarmPost(EV_MEMBER_LOST);
+			}
+			break;
+	}
+}
+
+/*
+ * Handles the frames received, in the order they arrived (see CanRxTask).
+*/
+static void CanRxTask(void *p_arg) {
+	INT8U err;
+	BUFFER_CAN* frame;
+	(void)p_arg;
+	while(1) {
+		frame = (BUFFER_CAN*)OSQPend(canRxQ, 0, &err);
+		TRACE_EVENT_ADD(TRACE_Q_GET, canRxQ, frame);
+		actOnRecv(frame);
+		MsgFree(frame);
+	}
+}
+
+/*
+ * Copies a received frame in a message of its own and gives it to CanRxTask :
+ * the DMA buffer is free again at once, and the frame is handled in a task,
+ * where the mutexes can be taken. When the pool is empty the frame is
+ * dropped (canRxPool.exhausted), as the controller would have done.
+*/
+static void canRxPost(BUFFER_CAN* source) {
+	BUFFER_CAN* frame = (BUFFER_CAN*)MsgAlloc(&canRxPool);
+	unsigned char i;
+	if(frame == (BUFFER_CAN*)0) {
+		return;
+	}
+	for(i = 0; i < 8; i++) {
+		frame->u16Words[i] = source->u16Words[i];
 	}
+	MsgPost(canRxQ, frame);
 }
 
-void __attribute__((interrupt, no_auto_psv))_C1Interrupt(void)
+void CanRx_ISR_Handler(void)
 {
+	TRACE_RECORD_ADD(TRACE_ISR_ENTER, TRACE_ISR_CAN_RX, 0);
+	NodeIdMix(TMR3);	// arrival times feed the nonces of the id claims
 	if (CAN_RX_BUFFER_IF){
 		if(CAN_RX_BUFFER_0){
-			actOnRecv(0);
+			canRxPost(&receiveBuffers[0]);
 			CAN_RX_BUFFER_0 = 0;
 		}
 		if(CAN_RX_BUFFER_1){
-			actOnRecv(1);
+			canRxPost(&receiveBuffers[1]);
 			CAN_RX_BUFFER_1 = 0;
 		}
 		if(CAN_RX_BUFFER_2){
-			actOnRecv(2);
+			canRxPost(&receiveBuffers[2]);
 			CAN_RX_BUFFER_2 = 0;
 		}
 		if(CAN_RX_BUFFER_3){
-			actOnRecv(3);
+			canRxPost(&receiveBuffers[3]);
 			CAN_RX_BUFFER_3 = 0;
 		}
 		if(CAN_RX_BUFFER_4){
-			actOnRecv(4);
+			canRxPost(&receiveBuffers[4]);
 			CAN_RX_BUFFER_4 = 0;
 		}
 		if(CAN_RX_BUFFER_5){
-			actOnRecv(5);
+			canRxPost(&receiveBuffers[5]);
 			CAN_RX_BUFFER_5 = 0;
 		}
 		CAN_RX_BUFFER_IF = 0;
 	}
 	CAN_INTERRUPT_FLAG = 0;
+	TRACE_RECORD_ADD(TRACE_ISR_EXIT, TRACE_ISR_CAN_RX, 0);
 }
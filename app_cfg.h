@@ -35,6 +35,19 @@
 #define  uC_PROBE_OS_PLUGIN               DEF_ENABLED
 #define  uC_PROBE_COM_MODULE              DEF_ENABLED
 
+#define  APP_STATE_BENCH_EN                     0                       /* Measure the cost of the state getters at start-up        */
+#define  APP_PWD_BENCH_EN                       0                       /* Measure keypress-to-unlock latency and password wake-ups */
+#define  APP_BUTTON_BENCH_EN                    0                       /* Measure the intrusion edge-to-frame latency (cycles)     */
+#define  APP_LCD_BENCH_EN                       0                       /* Measure OSCPUUsage while the LCD is redrawn continuously */
+#define  APP_DISPLAY_BENCH_EN                   0                       /* Count the renders saved by coalescing under a burst      */
+
+#define  APP_CYCLIC_EXEC_EN                     0                       /* Keypad, buttons and password as steps of one frame task  */
+#define  APP_CYCLIC_FRAME_TICKS                10                       /* Period of that frame (ticks), also the keypad scan period */
+
+#define  APP_TRACE_EN                           0                       /* Record the schedule in a RAM ring (see tools/trace2json) */
+#define  APP_PROFILE_EN                         1                       /* Account the CPU time of each task (see Profile.h)        */
+#define  APP_STACK_MONITOR_EN                   1                       /* Track the stack peaks and recommend sizes (see Stack.h)  */
+
 
 
 #define  OS_PROBE_TASK_PRIO                     8                       /* See probe_com_cfg for RS-232 communication task priority */
@@ -14,6 +14,12 @@
 */
 
 #include  <includes.h>
+#include  "Keyboard.h"
+#include  "Buttons.h"
+#include  "Zones.h"
+#include  "Trace.h"
+#include  "Profile.h"
+#include  "Stack.h"
 
 /*
 *********************************************************************************************************
@@ -32,9 +38,11 @@ void  App_TaskCreateHook (OS_TCB *ptcb)
 {
 #if (uC_PROBE_OS_PLUGIN > 0) && (OS_PROBE_HOOKS_EN > 0)
     OSProbe_TaskCreateHook(ptcb);
-#else
-    (void)ptcb;
 #endif
+#if APP_PROFILE_EN > 0
+    ProfileTaskCreate(ptcb);                                            /* Gives the task its slot of profile[]                     */
+#endif
+    (void)ptcb;
 }
 
 /*
@@ -86,6 +94,12 @@ void  App_TaskIdleHook (void)
 
 void  App_TaskStatHook (void)
 {
+#if APP_PROFILE_EN > 0
+    ProfilePublish();                                                   /* CPU time of each task over the period                    */
+#endif
+#if APP_STACK_MONITOR_EN > 0
+    StackMonitor();                                                     /* Stack peak and recommended size of each task             */
+#endif
 }
 
 /*
@@ -109,6 +123,10 @@ void  App_TaskSwHook (void)
 {
 #if (uC_PROBE_OS_PLUGIN > 0) && (OS_PROBE_HOOKS_EN > 0)
     OSProbe_TaskSwHook();
+#endif
+    TRACE_RECORD_ADD(TRACE_SWITCH, OSTCBHighRdy->OSTCBPrio, OSTCBCur->OSTCBPrio);
+#if APP_PROFILE_EN > 0
+    ProfileSwitch();                                                    /* Ends the slice of the task switched out                  */
 #endif
 }
 #endif
@@ -150,6 +168,14 @@ void  App_TimeTickHook (void)
 #if (uC_PROBE_OS_PLUGIN > 0) && (OS_PROBE_HOOKS_EN > 0)
     OSProbe_TickHook();
 #endif
+#if TRACE_TICKS_EN > 0
+    TRACE_RECORD_ADD(TRACE_TICK, 0, OSTime);                            /* The tick ISR itself is not traced : this stands for it   */
+#endif
+#if APP_CYCLIC_EXEC_EN == 0
+    KeyboardTickHook();                                                 /* Watches (and scans while a key is held) the keypad       */
+#endif
+    ButtonsTickHook();                                                  /* Ends the button lockouts, times the INTRUSION hold       */
+    ZonesTickHook();                                                    /* Debounces the sensor zones                               */
 }
 #endif
 
@@ -0,0 +1,328 @@
+//////////////////////////////////////////////////////////////////////////////
+//																			//
+//					Heartbeat scaling benchmark (host)						//
+//																			//
+//	Drives the heartbeat path of a node with the sources of the firmware	//
+//	(HeartBeat.c, Membership.c) on the host, for a group of 'nodes' nodes :	//
+//		- HeartBeatFunc : HeartBeatEncode of our own heartbeat (5s)			//
+//		- actOnRecv : HeartBeatStore + MembershipHeard of each heartbeat	//
+//		- CheckerTimerFunc : MembershipTick + MembershipExpired (100ms)		//
+//	app.c itself needs uC/OS-II and the dsPIC registers, so the calls it	//
+//	makes are replayed here in the same order.								//
+//																			//
+//	The tables are sized at compile time, as on the target :				//
+//		cc -O2 -DNUMBER_NODES=<nodes> -I.. HeartBeatBench.c					//
+//			../HeartBeat.c ../Membership.c -o hb_bench						//
+//		./hb_bench <nodes> [simulated seconds] [baudrate]					//
+//	(run.sh does it for 10 to 2000 nodes).									//
+//																			//
+//	One JSON object is printed per run.										//
+//																			//
+//////////////////////////////////////////////////////////////////////////////
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "HeartBeat.h"
+#include "Membership.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//									CONSTANTES								//
+//////////////////////////////////////////////////////////////////////////////
+#define HEARTBEAT_PERIOD_MS		5000	// heartBeatTimer (app.c)
+#define CHECK_PERIOD_MS			100		// HBCheckerTimer (app.c)
+#define WARMUP_MS				10000	// Every node heard at least once before the first failure
+#define MAX_FAILURES			4
+#define SELF					0		// Id of the node under test
+
+// Values of CAN_BAUDRATE (CanDspic.h), the node runs at 500kbps (main)
+static const unsigned long baudrates[] = {1000000, 500000, 250000, 125000};
+#define NUMBER_BAUDRATES		(sizeof(baudrates) / sizeof(baudrates[0]))
+#define DEFAULT_BAUDRATE		500000
+
+//////////////////////////////////////////////////////////////////////////////
+//									VARIABLES								//
+//////////////////////////////////////////////////////////////////////////////
+typedef struct _FRAME
+{
+	double delivered;		// ms, end of the frame on the bus
+	unsigned int sender;
+	unsigned char bits;		// on the bus, stuffing and interframe space included
+} FRAME;
+
+static FRAME* frames;
+static unsigned long frameCount;
+
+static unsigned int nodes;
+static unsigned long durationMs;
+static unsigned long baudrate;
+
+static unsigned int failedId[MAX_FAILURES];
+static unsigned long failedAt[MAX_FAILURES];
+static unsigned int failures;
+
+//////////////////////////////////////////////////////////////////////////////
+//								CAN FRAME LENGTH							//
+//////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Number of bits of a standard data frame on the bus, computed from its actual
+ * content : the stuffed part (SOF to CRC) is built bit by bit and a stuff bit
+ * is counted after 5 identical bits, then the fixed tail is added (CRC and ACK
+ * delimiters, ACK slot, EOF, interframe space).
+*/
+static unsigned char frameBits(unsigned int sid, unsigned char dlc, unsigned char* data)
+{
+	unsigned char bits[19 + 64 + 15];
+	unsigned int n = 0, i, b;
+	unsigned int crc = 0;
+	unsigned char run = 0, last = 2, stuffed = 0;
+
+	bits[n++] = 0;											// SOF
+	for(i = 0; i < 11; i++)	bits[n++] = (sid >> (10 - i)) & 1;	// identifier
+	bits[n++] = 0;											// RTR
+	bits[n++] = 0;											// IDE
+	bits[n++] = 0;											// r0
+	for(i = 0; i < 4; i++)	bits[n++] = (dlc >> (3 - i)) & 1;
+	for(i = 0; i < dlc; i++) {
+		for(b = 0; b < 8; b++)	bits[n++] = (data[i] >> (7 - b)) & 1;
+	}
+	for(i = 0; i < n; i++) {								// CRC-15, polynomial 0x4599
+		unsigned int next = bits[i] ^ ((crc >> 14) & 1);
+		crc = (crc << 1) & 0x7FFF;
+		if(next) crc ^= 0x4599;
+	}
+	for(i = 0; i < 15; i++)	bits[n++] = (crc >> (14 - i)) & 1;
+	for(i = 0; i < n; i++) {
+		if(bits[i] == last) {
+			run++;
+		}
+		else {
+			last = bits[i];
+			run = 1;
+		}
+		if(run == 5) {
+			stuffed++;
+			last = !last;	// the stuff bit starts the next run
+			run = 1;
+		}
+	}
+	return n + stuffed + 1 + 2 + 7 + 3;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//								SCHEDULE									//
+//////////////////////////////////////////////////////////////////////////////
+
+static unsigned char nodeFailedAt(unsigned int id, unsigned long t)
+{
+	unsigned int i;
+	for(i = 0; i < failures; i++) {
+		if(failedId[i] == id && t >= failedAt[i]) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Every node sends its heartbeat every 5s, the nodes being evenly spread over
+ * the period (their timers started at different times). The frames share the
+ * bus : a frame waits for the end of the previous one.
+*/
+static void buildSchedule(void)
+{
+	unsigned long period, t;
+	unsigned int id;
+	double busFree = 0;
+	unsigned char payload[HB_DLC];
+	NODE_STATUS status = {0, 0, 0, 0, 0};
+
+	frames = malloc(sizeof(FRAME) * ((durationMs / HEARTBEAT_PERIOD_MS + 1) * nodes));
+	frameCount = 0;
+	for(period = 0; period * HEARTBEAT_PERIOD_MS < durationMs; period++) {
+		for(id = 0; id < nodes; id++) {
+			t = period * HEARTBEAT_PERIOD_MS + (unsigned long)id * HEARTBEAT_PERIOD_MS / nodes;
+			if(t >= durationMs || nodeFailedAt(id, t)) {
+				continue;
+			}
+			HeartBeatEncode(payload, id, &status);
+			frames[frameCount].sender = id;
+			frames[frameCount].bits = frameBits(heartbeat, HB_DLC, payload);
+			if(busFree < t) {
+				busFree = t;
+			}
+			busFree += frames[frameCount].bits * 1000.0 / baudrate;
+			frames[frameCount].delivered = busFree;
+			frameCount++;
+		}
+	}
+}
+
+/*
+ * Some peers stop sending their heartbeat, each one at a different instant
+ * after its last heartbeat so that the whole range of detection times (from
+ * failing just after a heartbeat to failing just before the next one) is
+ * covered.
+*/
+static void chooseFailures(void)
+{
+	unsigned int i;
+	failures = (nodes - 1 < MAX_FAILURES) ? nodes - 1 : MAX_FAILURES;
+	for(i = 0; i < failures; i++) {
+		failedId[i] = 1 + (i + 1) * (nodes - 1) / (failures + 1);
+		failedAt[i] = WARMUP_MS + (unsigned long)failedId[i] * HEARTBEAT_PERIOD_MS / nodes + 1 + i * HEARTBEAT_PERIOD_MS / failures;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//								MEASURES									//
+//////////////////////////////////////////////////////////////////////////////
+
+static double cpuNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// What the node does in HeartBeatFunc once the state is gathered
+static void heartBeatTx(void)
+{
+	unsigned char payload[HB_DLC];
+	NODE_STATUS status = {0, 0, 0, 0, 0};
+	status.epoch = membershipEpoch;
+	HeartBeatEncode(payload, SELF, &status);
+}
+
+// Heartbeat branch of actOnRecv (the peers carry the epoch of the group)
+static void heartBeatRx(unsigned int sender, unsigned int groupEpoch)
+{
+	unsigned char payload[HB_DLC];
+	NODE_STATUS status = {0, 0, 0, 0, 0};
+	unsigned int index;
+	status.epoch = groupEpoch;
+	HeartBeatEncode(payload, sender, &status);
+	index = HeartBeatStore(payload, HB_DLC);
+	if(index != HB_INVALID_ID) {
+		MembershipHeard(index, nodeStatus[index].epoch);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long f = 0, t, checks = 0, sent = 0, i;
+	unsigned int id, k;
+	unsigned int groupEpoch;
+	unsigned long detected[MAX_FAILURES];
+	unsigned long falseEvictions = 0, evictFrames = 0;
+	unsigned long bitsSum = 0, bitsMax = 0, detectMin = 0, detectMax = 0, detectSum = 0;
+	unsigned int missed = 0;
+	double start, total, tx, rx, checker;
+
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <nodes> [simulated seconds] [baudrate]\n", argv[0]);
+		return 1;
+	}
+	nodes = atoi(argv[1]);
+	durationMs = (argc > 2) ? atol(argv[2]) * 1000 : 60000;
+	baudrate = (argc > 3) ? atol(argv[3]) : DEFAULT_BAUDRATE;
+	if(nodes < 2 || nodes > NUMBER_NODES) {
+		fprintf(stderr, "nodes must be in [2, %d] (NUMBER_NODES)\n", NUMBER_NODES);
+		return 1;
+	}
+
+	chooseFailures();
+	buildSchedule();
+	for(i = 0; i < frameCount; i++) {
+		bitsSum += frames[i].bits;
+		if(frames[i].bits > bitsMax) bitsMax = frames[i].bits;
+	}
+	memset(detected, 0, sizeof(detected));
+
+	// Node under test, started with the others
+	MembershipInit(SELF);
+	groupEpoch = MembershipLocalEvent(MEMBER_JOIN, SELF);
+
+	start = cpuNs();
+	for(t = 0; t < durationMs; t += CHECK_PERIOD_MS) {
+		// Frames received since the previous check
+		while(f < frameCount && frames[f].delivered < t) {
+			if(frames[f].sender == SELF) {
+				heartBeatTx();
+				sent++;
+			}
+			else {
+				heartBeatRx(frames[f].sender, groupEpoch);
+			}
+			f++;
+		}
+		MembershipTick();
+		checks++;
+		for(id = MembershipExpired(0); id != MEMBER_NONE; id = MembershipExpired(id + 1)) {
+			// The eviction is sent, the peers adopt its epoch
+			groupEpoch = MembershipLocalEvent(MEMBER_EVICT, id);
+			evictFrames++;
+			for(k = 0; k < failures && failedId[k] != id; k++);
+			if(k < failures && t >= failedAt[k]) {
+				detected[k] = t - failedAt[k];
+			}
+			else {
+				falseEvictions++;
+			}
+		}
+	}
+	total = cpuNs() - start;
+
+	// Each path alone, replayed with the same number of calls
+	start = cpuNs();
+	for(i = 0; i < sent; i++) {
+		heartBeatTx();
+	}
+	tx = cpuNs() - start;
+	start = cpuNs();
+	for(i = 0; i < frameCount; i++) {
+		if(frames[i].sender != SELF) heartBeatRx(frames[i].sender, groupEpoch);
+	}
+	rx = cpuNs() - start;
+	start = cpuNs();
+	for(i = 0; i < checks; i++) {
+		MembershipTick();
+		MembershipRestartTimeouts();	// no eviction in the replay, the scan is the same
+		MembershipExpired(0);
+	}
+	checker = cpuNs() - start;
+
+	for(k = 0; k < failures; k++) {
+		if(!detected[k]) {
+			missed++;
+			continue;
+		}
+		if(detectMin == 0 || detected[k] < detectMin) detectMin = detected[k];
+		if(detected[k] > detectMax) detectMax = detected[k];
+		detectSum += detected[k];
+	}
+
+	printf("{\"benchmark\": \"heartbeat\", \"nodes\": %u, \"number_nodes\": %d, \"simulated_s\": %lu, \"baudrate\": %lu", nodes, NUMBER_NODES, durationMs / 1000, baudrate);
+	printf(", \"cpu_ns_per_protocol_s\": %.0f", total / (durationMs / 1000.0));
+	printf(", \"cpu_ns_per_protocol_s_by_path\": {\"heartbeat_tx\": %.0f, \"heartbeat_rx\": %.0f, \"checker\": %.0f}",
+			tx / (durationMs / 1000.0), rx / (durationMs / 1000.0), checker / (durationMs / 1000.0));
+	// On the target, int is 16 bits : NODE_STATUS is 4 bytes and an epoch
+	printf(", \"bytes_per_node\": {\"host\": %lu, \"target\": %u}",
+			(unsigned long)(sizeof(nodeStatus) + sizeof(members) + sizeof(memberCounter)) / NUMBER_NODES, 4 + 2 + 1 + 1);
+	printf(", \"frames_per_s\": %.2f, \"bits_per_frame\": {\"mean\": %.1f, \"max\": %lu}",
+			frameCount / (durationMs / 1000.0), (double)bitsSum / frameCount, bitsMax);
+	printf(", \"bus_utilization\": {");
+	for(i = 0; i < NUMBER_BAUDRATES; i++) {
+		printf("%s\"%lu\": %.4f", i ? ", " : "", baudrates[i], (double)bitsSum / (durationMs / 1000.0) / baudrates[i]);
+	}
+	printf("}, \"detect_ms\": {\"failures\": %u, \"missed\": %u, \"min\": %lu, \"mean\": %.0f, \"max\": %lu}",
+			failures, missed, detectMin, (failures > missed) ? (double)detectSum / (failures - missed) : 0.0, detectMax);
+	printf(", \"false_evictions\": %lu, \"evictions_sent\": %lu}\n", falseEvictions, evictFrames);
+
+	free(frames);
+	return 0;
+}
@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////////////
+//																			//
+//						Persistence test (host)								//
+//																			//
+//	Runs Persist.c on the host, over an emulated flash region which, as		//
+//	the device, can only clear bits when programmed and sets a whole page	//
+//	back to 0xFFFF when erased (PERSIST_HOST_EMULATION) :					//
+//		- a blank region holds no record									//
+//		- 'saves' different records round-trip through the two pages, each	//
+//		  one read back by a fresh scan (as after a reset)					//
+//		- an unchanged record is not written again							//
+//		- the pages are erased in turn (wear leveling)						//
+//		- a corrupted latest record falls back to the previous one			//
+//		- the sequence number wraps past 0xFFFF (erased value skipped)		//
+//																			//
+//		cc -O2 -DPERSIST_HOST_EMULATION -I.. PersistTest.c ../Persist.c		//
+//			-o persist_test													//
+//		./persist_test [saves]												//
+//																			//
+//	Prints one line per check, the exit status is 0 if all of them pass.	//
+//																			//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Persist.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//									CONSTANTES								//
+//////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_SAVES			1000
+#define WRAP_SAVES				70000UL		// More than the 65535 sequence numbers
+
+//////////////////////////////////////////////////////////////////////////////
+//									VARIABLES								//
+//////////////////////////////////////////////////////////////////////////////
+static unsigned int failed = 0;
+
+//////////////////////////////////////////////////////////////////////////////
+//									HELPERS									//
+//////////////////////////////////////////////////////////////////////////////
+
+static void check(int ok, const char* what)
+{
+	printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+	if(!ok) {
+		failed++;
+	}
+}
+
+// A record whose every field depends on 'n', so that two successive ones differ
+static void makeRecord(unsigned long n, PERSIST_RECORD* record)
+{
+	memset(record, 0, sizeof(*record));
+	record->nodeId = n % 16;
+	record->state = (n >> 4) & 0x07;
+	record->configGeneration = n & 0xFF;
+	record->passwordGeneration = (n >> 8) & 0xFF;
+	record->password[0] = '0' + n % 10;
+	record->password[1] = '0' + (n / 10) % 10;
+	record->password[2] = '0' + (n / 100) % 10;
+	record->password[3] = '0' + (n / 1000) % 10;
+	record->idleCtrMax = 100000UL + n;
+}
+
+static int sameRecord(PERSIST_RECORD* a, PERSIST_RECORD* b)
+{
+	return a->sequence == b->sequence && a->nodeId == b->nodeId && a->state == b->state
+		&& a->configGeneration == b->configGeneration && a->passwordGeneration == b->passwordGeneration
+		&& memcmp(a->password, b->password, PERSIST_PASSWORD_SIZE) == 0
+		&& a->idleCtrMax == b->idleCtrMax;
+}
+
+// Index in the emulated flash of the record carrying 'sequence', -1 if none
+static long findRecord(unsigned int sequence)
+{
+	unsigned long i;
+
+	for(i = 0; i < PERSIST_PAGES*PERSIST_PAGE_WORDS; i += PERSIST_RECORD_WORDS) {
+		if(persistHostFlash[i] == sequence) {
+			return (long)i;
+		}
+	}
+	return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//									TESTS									//
+//////////////////////////////////////////////////////////////////////////////
+
+static void testRoundTrip(unsigned long saves)
+{
+	PERSIST_RECORD saved, loaded;
+	unsigned long n, errors = 0;
+	unsigned long low, high;
+	char what[80];
+
+	PersistHostReset();
+	check(!PersistLoad(&loaded), "blank region holds no record");
+
+	for(n = 0; n < saves; n++) {
+		makeRecord(n, &saved);
+		PersistSave(&saved);
+		if(!PersistLoad(&loaded) || !sameRecord(&saved, &loaded) || loaded.sequence != (n & 0xFFFF)) {
+			errors++;
+		}
+	}
+	sprintf(what, "%lu saves read back after a rescan (%lu errors)", saves, errors);
+	check(errors == 0, what);
+
+	low = high = persistHostErases[0];
+	for(n = 1; n < PERSIST_PAGES; n++) {
+		if(persistHostErases[n] < low) low = persistHostErases[n];
+		if(persistHostErases[n] > high) high = persistHostErases[n];
+	}
+	sprintf(what, "pages erased in turn (%lu to %lu erases per page)", low, high);
+	check(saves < PERSIST_PAGE_WORDS / PERSIST_RECORD_WORDS || (high - low <= 1 && low > 0), what);
+
+	n = persistHostErases[0] + persistHostErases[1];
+	PersistSave(&saved);
+	check(findRecord(saved.sequence + 1) < 0 && persistHostErases[0] + persistHostErases[1] == n,
+		"unchanged record not written again");
+}
+
+static void testCorruption(void)
+{
+	PERSIST_RECORD previous, latest, loaded;
+	long index;
+
+	PersistHostReset();
+	makeRecord(1, &previous);
+	PersistSave(&previous);
+	makeRecord(2, &latest);
+	PersistSave(&latest);
+
+	// A bit cleared in the middle of the latest record, as if power was lost while writing it
+	index = findRecord(latest.sequence);
+	check(index >= 0, "latest record found in the region");
+	if(index < 0) {
+		return;
+	}
+	persistHostFlash[index + 3] &= ~0x0010;
+	check(PersistLoad(&loaded) && sameRecord(&loaded, &previous), "corrupted latest record falls back to the previous one");
+
+	// The next save goes after the corrupted slot and wins again
+	makeRecord(3, &latest);
+	PersistSave(&latest);
+	check(PersistLoad(&loaded) && sameRecord(&loaded, &latest), "save after a corrupted record is read back");
+}
+
+static void testWrap(void)
+{
+	PERSIST_RECORD saved, loaded;
+	unsigned long n;
+	int erased = 0;
+
+	PersistHostReset();
+	for(n = 0; n < WRAP_SAVES; n++) {
+		makeRecord(n, &saved);
+		PersistSave(&saved);
+		if(saved.sequence == 0xFFFF) {
+			erased = 1;
+		}
+	}
+	check(!erased, "sequence number never takes the erased value");
+	check(PersistLoad(&loaded) && sameRecord(&loaded, &saved), "latest record read back once the sequence wrapped");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//									MAIN									//
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	unsigned long saves = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_SAVES;
+
+	testRoundTrip(saves);
+	testCorruption();
+	testWrap();
+	printf("%s\n", failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
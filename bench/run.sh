@@ -0,0 +1,12 @@
+#!/bin/sh
+# Heartbeat scaling benchmark : one JSON object per group size on stdout.
+# The tables being sized at build time (NUMBER_NODES), the benchmark is built
+# for each size. Usage : ./run.sh [simulated seconds] [baudrate] > results.jsonl
+cd "$(dirname "$0")" || exit 1
+CC=${CC:-cc}
+OUT=$(mktemp -d) || exit 1
+trap 'rm -rf "$OUT"' EXIT
+for NODES in 10 20 50 100 200 500 1000 2000; do
+	$CC -O2 -DNUMBER_NODES=$NODES -I.. HeartBeatBench.c ../HeartBeat.c ../Membership.c -o "$OUT/hb_bench" || exit 1
+	"$OUT/hb_bench" $NODES "$@" || exit 1
+done
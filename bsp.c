@@ -47,6 +47,7 @@
 
 static  void  BSP_PLL_Init(void);
 static  void  Tmr_TickInit(void);
+static  void  Tmr_CycleInit(void);
 
 /*
 *********************************************************************************************************
@@ -66,6 +67,7 @@ void  BSP_Init (void)
     BSP_PLL_Init();                                                     /* Initialize the PLL                                       */
     LED_Init();                                                         /* Initialize the I/Os for the LED controls                 */
     Tmr_TickInit();                                                     /* Initialize the uC/OS-II tick interrupt                   */
+    Tmr_CycleInit();                                                    /* Initialize the 32 bit cycle counter                      */
 }
 
 /*
@@ -394,6 +396,53 @@ static  void  Tmr_TickInit (void)
 #endif
 }
 
+/*
+*********************************************************************************************************
+*                                       CYCLE COUNTER INITIALIZATION
+*
+* Description : This function starts timers 8 and 9 as one free running 32 bit timer counting the cycles.
+*               Unlike the 16 bit uC/Probe timer (TMR3, 1.6ms), it times the longest task slices : it
+*               only wraps every 107s.
+*
+* Arguments   : none
+*
+* Note(s)     : 1) The timer operates at a frequency of Fcy, no prescaler
+*********************************************************************************************************
+*/
+
+static  void  Tmr_CycleInit (void)
+{
+    T8CON     =   0;
+    T9CON     =   0;
+    TMR9      =   0;                                                    /* Start counting from 0                                    */
+    TMR8      =   0;
+    PR9       =   0xFFFF;                                               /* Set the period registers to their maximum value          */
+    PR8       =   0xFFFF;
+    T8CON     =   T32;                                                  /* Use Internal Osc (Fcy), 32 bit mode (timer 9 extends 8)  */
+    T8CON    |=   TON;                                                  /* Start the timer                                          */
+}
+
+/*
+*********************************************************************************************************
+*                                       BSP_CycleTmrRd()
+*
+* Description : This function reads the 32 bit cycle counter (Fcy).
+*
+* Returns     : The count of timers 8 and 9.
+*
+* Note(s)     : 1) Reading TMR8 latches TMR9 into TMR9HLD : the two halves are consistent.
+*********************************************************************************************************
+*/
+
+CPU_INT32U  BSP_CycleTmrRd (void)
+{
+    CPU_INT16U  lsw;
+
+
+    lsw = TMR8;
+    return (((CPU_INT32U)TMR9HLD << 16) | lsw);
+}
+
 /*
 *********************************************************************************************************
 *                                     OS TICK INTERRUPT SERVICE ROUTINE
@@ -64,6 +64,7 @@ typedef  void (*PFNCT)(void);
 #define  PLLDIV_MASK                (CPU_INT16U)(0xFF <<  0)
                                                                         /* Timer Control register bits                              */
 #define  TON                        (CPU_INT16U)(1 << 15)
+#define  T32                        (CPU_INT16U)(1 <<  3)
                                                                         /* IPC1 Interrupt Priority register bits                    */
 #define  T2IP_MASK                  (CPU_INT16U)(7 << 12)
                                                                         /* IPC5 Interrupt Priority register bits                    */
@@ -109,6 +110,7 @@ void        BSP_IntDis(CPU_INT08U IntCont, CPU_INT08U IntNum);
 void        BSP_IntDisAll(void);
 
 CPU_INT32U  BSP_CPU_ClkFrq(void);
+CPU_INT32U  BSP_CycleTmrRd(void);
 
 /*
 *********************************************************************************************************
@@ -47,6 +47,10 @@
 
     .global __T2Interrupt
     .global __T4Interrupt
+    .global __IC5Interrupt
+    .global __IC6Interrupt
+    .global __DMA2Interrupt
+    .global __C1Interrupt
 
 ;
 ;********************************************************************************************************
@@ -108,3 +112,115 @@ T4_Cont:
     retfie                                                              ; 7) Return from interrupt
 
 
+;
+;********************************************************************************************************
+;                                            Intrusion Button ISR Handler
+;
+; Description : This function services the IC5 interrupt (see Buttons.c)
+;********************************************************************************************************
+;
+
+__IC5Interrupt:
+    OS_REGS_SAVE                                                        ; 1) Save processor registers
+
+    mov   #_OSIntNesting, w1
+    inc.b [w1], [w1]                                                    ; 2) Call OSIntEnter() or increment OSIntNesting
+
+    dec.b _OSIntNesting, wreg                                           ; 3) Check OSIntNesting. if OSIntNesting == 1, then save the stack pointer, otherwise jump to IC5_Cont
+    bra nz, IC5_Cont
+    mov _OSTCBCur, w0
+    mov w15, [w0]
+
+IC5_Cont:
+    call _ButtonIC5_ISR_Handler                                               ; 4) Call YOUR ISR Handler (May be a C function)
+    call _OSIntExit                                                     ; 5) Call OSIntExit() or decrement 1 from OSIntNesting
+
+    OS_REGS_RESTORE                                                     ; 6) Restore registers
+
+    retfie                                                              ; 7) Return from interrupt
+
+
+;
+;********************************************************************************************************
+;                                            Password Change Button ISR Handler
+;
+; Description : This function services the IC6 interrupt (see Buttons.c)
+;********************************************************************************************************
+;
+
+__IC6Interrupt:
+    OS_REGS_SAVE                                                        ; 1) Save processor registers
+
+    mov   #_OSIntNesting, w1
+    inc.b [w1], [w1]                                                    ; 2) Call OSIntEnter() or increment OSIntNesting
+
+    dec.b _OSIntNesting, wreg                                           ; 3) Check OSIntNesting. if OSIntNesting == 1, then save the stack pointer, otherwise jump to IC6_Cont
+    bra nz, IC6_Cont
+    mov _OSTCBCur, w0
+    mov w15, [w0]
+
+IC6_Cont:
+    call _ButtonIC6_ISR_Handler                                               ; 4) Call YOUR ISR Handler (May be a C function)
+    call _OSIntExit                                                     ; 5) Call OSIntExit() or decrement 1 from OSIntNesting
+
+    OS_REGS_RESTORE                                                     ; 6) Restore registers
+
+    retfie                                                              ; 7) Return from interrupt
+
+
+;
+;********************************************************************************************************
+;                                            Analog Sensors DMA ISR Handler
+;
+; Description : This function services the DMA2 interrupt : a block of ADC1 samples is complete (see Analog.c)
+;********************************************************************************************************
+;
+
+__DMA2Interrupt:
+    OS_REGS_SAVE                                                        ; 1) Save processor registers
+
+    mov   #_OSIntNesting, w1
+    inc.b [w1], [w1]                                                    ; 2) Call OSIntEnter() or increment OSIntNesting
+
+    dec.b _OSIntNesting, wreg                                           ; 3) Check OSIntNesting. if OSIntNesting == 1, then save the stack pointer, otherwise jump to DMA2_Cont
+    bra nz, DMA2_Cont
+    mov _OSTCBCur, w0
+    mov w15, [w0]
+
+DMA2_Cont:
+    call _AnalogDMA2_ISR_Handler                                        ; 4) Call YOUR ISR Handler (May be a C function)
+    call _OSIntExit                                                     ; 5) Call OSIntExit() or decrement 1 from OSIntNesting
+
+    OS_REGS_RESTORE                                                     ; 6) Restore registers
+
+    retfie                                                              ; 7) Return from interrupt
+
+
+;
+;********************************************************************************************************
+;                                            CAN Reception ISR Handler
+;
+; Description : This function services the ECAN1 interrupt : the frames received are queued for CanRxTask (see app.c)
+;********************************************************************************************************
+;
+
+__C1Interrupt:
+    OS_REGS_SAVE                                                        ; 1) Save processor registers
+
+    mov   #_OSIntNesting, w1
+    inc.b [w1], [w1]                                                    ; 2) Call OSIntEnter() or increment OSIntNesting
+
+    dec.b _OSIntNesting, wreg                                           ; 3) Check OSIntNesting. if OSIntNesting == 1, then save the stack pointer, otherwise jump to C1_Cont
+    bra nz, C1_Cont
+    mov _OSTCBCur, w0
+    mov w15, [w0]
+
+C1_Cont:
+    call _CanRx_ISR_Handler                                             ; 4) Call YOUR ISR Handler (May be a C function)
+    call _OSIntExit                                                     ; 5) Call OSIntExit() or decrement 1 from OSIntNesting
+
+    OS_REGS_RESTORE                                                     ; 6) Restore registers
+
+    retfie                                                              ; 7) Return from interrupt
+
+
@@ -13,14 +13,15 @@
 
 void init_elec_h_410(void)
 {
-	DIO1_TRIS = 0;
-	DIO2_TRIS = 0;
-	DIO3_TRIS = 0;
-	DIO4_TRIS = 0;
-	DIO5_TRIS = 0;
-	DIO6_TRIS = 0;
-	DIO7_TRIS = 0;
-	DIO8_TRIS = 0;
+	// sensor zones (see Zones.c)
+	DIO1_TRIS = 1;
+	DIO2_TRIS = 1;
+	DIO3_TRIS = 1;
+	DIO4_TRIS = 1;
+	DIO5_TRIS = 1;
+	DIO6_TRIS = 1;
+	DIO7_TRIS = 1;
+	DIO8_TRIS = 1;
 
 	TASK_ENABLE_TRIS1 = 0;
 	TASK_ENABLE_TRIS2 = 0;
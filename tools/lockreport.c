@@ -0,0 +1,155 @@
+//////////////////////////////////////////////////////////////////////////////
+//																			//
+//					Mutex contention report (host)							//
+//																			//
+//	Ranks the mutexes of the node by the time the tasks spent waiting for	//
+//	them, from a dump of 'lockStats' (Lock.h) : how often each one was		//
+//	taken, how often it was already held, the priority inheritance boosts,	//
+//	the waits and the holds. A mutex never found held by another task is a	//
+//	candidate for removal, or for merging with another one.					//
+//																			//
+//	The dump is the 'lockStats' variable as is (LOCKS records of 46 bytes,	//
+//	little endian, 16-bit pointers), exported from the debugger :			//
+//		cc -O2 lockreport.c -o lockreport									//
+//		./lockreport lockstats.bin [Fcy in Hz]								//
+//																			//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////////
+//									CONSTANTES								//
+//////////////////////////////////////////////////////////////////////////////
+// Layout of LOCK_STATS (Lock.h)
+#define RECORD_BYTES		46
+#define OFFSET_PENDS		0
+#define OFFSET_CONTENDED	4
+#define OFFSET_BOOSTS		8
+#define OFFSET_WAIT			12
+#define OFFSET_WAIT_MAX		16
+#define OFFSET_HOLD			20
+#define OFFSET_HOLD_MAX		24
+#define OFFSET_PIP			32
+#define OFFSET_OWNER		33
+#define OFFSET_NAME			34
+#define LOCK_NAME_SIZE		10
+#define LOCK_FREE			0xFF
+
+#define DEFAULT_FCY			40000000	// BSP_CPU_ClkFrq() of the node (bsp.c)
+
+//////////////////////////////////////////////////////////////////////////////
+//									VARIABLES								//
+//////////////////////////////////////////////////////////////////////////////
+typedef struct _LOCK
+{
+	char name[LOCK_NAME_SIZE + 1];
+	unsigned int pip;
+	unsigned int owner;
+	unsigned long pends;
+	unsigned long contended;
+	unsigned long boosts;
+	double wait;		// us
+	double waitMax;
+	double hold;
+	double holdMax;
+} LOCK;
+
+//////////////////////////////////////////////////////////////////////////////
+//									MAIN									//
+//////////////////////////////////////////////////////////////////////////////
+
+static unsigned long le(const unsigned char* p, int bytes)
+{
+	unsigned long v = 0;
+	while(bytes--) {
+		v = (v << 8) | p[bytes];
+	}
+	return v;
+}
+
+static int byWait(const void* a, const void* b)
+{
+	const LOCK* x = a;
+	const LOCK* y = b;
+	if(x->wait != y->wait) {
+		return (x->wait < y->wait) ? 1 : -1;
+	}
+	return (x->contended < y->contended) ? 1 : (x->contended > y->contended) ? -1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+	FILE* file;
+	unsigned char record[RECORD_BYTES];
+	LOCK locks[64];
+	unsigned int count = 0, i;
+	double usPerCycle;
+
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <lockStats dump> [Fcy in Hz]\n", argv[0]);
+		return 1;
+	}
+	usPerCycle = 1e6 / ((argc > 2) ? atof(argv[2]) : DEFAULT_FCY);
+	file = fopen(argv[1], "rb");
+	if(!file) {
+		perror(argv[1]);
+		return 1;
+	}
+	while(count < sizeof(locks) / sizeof(locks[0]) && fread(record, 1, RECORD_BYTES, file) == RECORD_BYTES) {
+		LOCK* l = &locks[count];
+		memcpy(l->name, record + OFFSET_NAME, LOCK_NAME_SIZE);
+		l->name[LOCK_NAME_SIZE] = 0;
+		if(l->name[0] == 0) {
+			continue;	// slot not used
+		}
+		l->pip = record[OFFSET_PIP];
+		l->owner = record[OFFSET_OWNER];
+		l->pends = le(record + OFFSET_PENDS, 4);
+		l->contended = le(record + OFFSET_CONTENDED, 4);
+		l->boosts = le(record + OFFSET_BOOSTS, 4);
+		l->wait = le(record + OFFSET_WAIT, 4) * usPerCycle;
+		l->waitMax = le(record + OFFSET_WAIT_MAX, 4) * usPerCycle;
+		l->hold = le(record + OFFSET_HOLD, 4) * usPerCycle;
+		l->holdMax = le(record + OFFSET_HOLD_MAX, 4) * usPerCycle;
+		count++;
+	}
+	fclose(file);
+	if(count == 0) {
+		fprintf(stderr, "%s : no mutex in the dump\n", argv[1]);
+		return 1;
+	}
+	qsort(locks, count, sizeof(LOCK), byWait);
+
+	printf("rank mutex      pip   pends contended boosts  wait(ms) waitmax(us) avgwait(us)  hold(ms) holdmax(us) avghold(us) holder\n");
+	for(i = 0; i < count; i++) {
+		LOCK* l = &locks[i];
+		char holder[8];
+		if(l->owner == LOCK_FREE) {
+			strcpy(holder, "-");
+		}
+		else {
+			sprintf(holder, "%u", l->owner);
+		}
+		printf("%4u %-10s %3u %7lu %8.1f%% %6lu %9.3f %11.1f %11.1f %9.3f %11.1f %11.1f %s\n",
+			i + 1, l->name, l->pip, l->pends,
+			l->pends ? 100.0 * l->contended / l->pends : 0.0, l->boosts,
+			l->wait / 1000, l->waitMax, l->contended ? l->wait / l->contended : 0.0,
+			l->hold / 1000, l->holdMax, l->pends ? l->hold / l->pends : 0.0, holder);
+	}
+	printf("\n");
+	for(i = 0; i < count; i++) {
+		LOCK* l = &locks[i];
+		if(l->pends == 0) {
+			printf("%s : never taken\n", l->name);
+		}
+		else if(l->contended == 0) {
+			printf("%s : never found held, a candidate for removal or merging\n", l->name);
+		}
+		else if(l->boosts) {
+			printf("%s : the holder inherited priority %u %lu times\n", l->name, l->pip, l->boosts);
+		}
+	}
+	return 0;
+}
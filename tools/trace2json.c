@@ -0,0 +1,307 @@
+//////////////////////////////////////////////////////////////////////////////
+//																			//
+//					Trace converter (host)									//
+//																			//
+//	Turns a dump of the trace ring of the node (Trace.h, APP_TRACE_EN) into	//
+//	the JSON of the Chrome trace viewer (chrome://tracing) and Perfetto		//
+//	(ui.perfetto.dev) :														//
+//		- one row per task, a slice each time it runs						//
+//		- one row per interrupt, a slice per run							//
+//		- one row per mutex for the holds, one for the waits				//
+//		- one row per queue, an instant per post and per get				//
+//		- the ticks and the trigger as instants								//
+//																			//
+//	The dump is the 'trace' variable as is (count, size, left, frequency,	//
+//	then the records, little endian), exported from the debugger :			//
+//		cc -O2 trace2json.c -o trace2json									//
+//		./trace2json trace.bin > trace.json									//
+//																			//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////////
+//									CONSTANTES								//
+//////////////////////////////////////////////////////////////////////////////
+// Record types (Trace.h)
+#define TRACE_SWITCH		1
+#define TRACE_TICK			2
+#define TRACE_ISR_ENTER		3
+#define TRACE_ISR_EXIT		4
+#define TRACE_MUTEX_PEND	5
+#define TRACE_MUTEX_TAKEN	6
+#define TRACE_MUTEX_POST	7
+#define TRACE_Q_POST		8
+#define TRACE_Q_GET			9
+#define TRACE_TRIGGER		10
+
+#define HEADER_BYTES		12		// count, size, left, frequency
+#define RECORD_BYTES		8		// time, type, id, arg
+#define PRIOS				64		// OS_LOWEST_PRIO + 1 (os_cfg.h)
+#define EVENTS				32		// OS_MAX_EVENTS (os_cfg.h)
+#define ISRS				8
+
+// Rows of the viewer (tid), the tasks using their priority
+#define ROW_TICKS			100
+#define ROW_ISR				110
+#define ROW_MUTEX_HOLD		200
+#define ROW_MUTEX_WAIT		300
+#define ROW_QUEUE			400
+
+// Task priorities (app.c, app_cfg.h, probe_com_cfg.h)
+static const char* taskNames[PRIOS] = {
+	[2] = "Start",
+	[8] = "uC/Probe",
+	[9] = "uC/Probe RS-232",
+	[10] = "OS timers",
+	[11] = "CAN Rx",
+	[12] = "Button handler / Frame",
+	[13] = "Alarm",
+	[14] = "Password",
+	[16] = "LCD",
+	[62] = "OS statistics",
+	[63] = "OS idle",
+};
+
+// Interrupts (TRACE_ISR_xxx, Trace.h)
+static const char* isrNames[ISRS] = {
+	[1] = "IC5 intrusion button",
+	[2] = "IC6 password button",
+	[3] = "DMA2 analog block",
+	[4] = "ECAN1 reception",
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//									VARIABLES								//
+//////////////////////////////////////////////////////////////////////////////
+static double frequency;
+static int first = 1;
+
+// Start of the slices in progress (< 0 : none, or begun before the dump)
+static double isrStart[ISRS];
+static double waitStart[EVENTS][PRIOS];
+static double holdStart[EVENTS];
+static int holder[EVENTS];
+static unsigned char isMutex[EVENTS];
+static unsigned char isQueue[EVENTS];
+static unsigned char seen[PRIOS];
+
+//////////////////////////////////////////////////////////////////////////////
+//									OUTPUT									//
+//////////////////////////////////////////////////////////////////////////////
+
+static void separator(void)
+{
+	printf(first ? "\n" : ",\n");
+	first = 0;
+}
+
+static const char* taskName(int prio, char* buffer)
+{
+	if(prio < PRIOS && taskNames[prio]) {
+		return taskNames[prio];
+	}
+	sprintf(buffer, "Task %d", prio);
+	return buffer;
+}
+
+static void slice(int tid, const char* name, double ts, double end)
+{
+	separator();
+	printf("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", name, tid, ts, end - ts);
+}
+
+static void instant(int tid, const char* name, double ts, unsigned int arg)
+{
+	separator();
+	printf("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"arg\":%u}}", name, tid, ts, arg);
+}
+
+static void row(int tid, const char* name)
+{
+	separator();
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", tid, name);
+	separator();
+	printf("{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}", tid, tid);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//									MAIN									//
+//////////////////////////////////////////////////////////////////////////////
+
+static unsigned long le(const unsigned char* p, int bytes)
+{
+	unsigned long v = 0;
+	while(bytes--) {
+		v = (v << 8) | p[bytes];
+	}
+	return v;
+}
+
+int main(int argc, char** argv)
+{
+	FILE* file;
+	unsigned char* dump;
+	long length;
+	unsigned long count, size, records, start, i;
+	unsigned long long time, last = 0, wraps = 0, origin = 0;
+	int current = -1;
+	double since = 0, ts;
+	char name[64], other[32];
+	int k;
+
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s <trace dump>\n", argv[0]);
+		return 1;
+	}
+	file = fopen(argv[1], "rb");
+	if(!file) {
+		perror(argv[1]);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	dump = malloc(length > 0 ? length : 1);
+	if(!dump || length < HEADER_BYTES || fread(dump, 1, length, file) != (size_t)length) {
+		fprintf(stderr, "%s : not a trace dump\n", argv[1]);
+		return 1;
+	}
+	fclose(file);
+	for(k = 0; k < EVENTS * PRIOS; k++) {
+		waitStart[k / PRIOS][k % PRIOS] = -1;
+	}
+	for(k = 0; k < EVENTS; k++) {
+		holdStart[k] = -1;
+	}
+	for(k = 0; k < ISRS; k++) {
+		isrStart[k] = -1;
+	}
+
+	count = le(dump, 4);
+	size = le(dump + 4, 2);
+	frequency = (double)le(dump + 8, 4);
+	if(size == 0 || frequency == 0 || HEADER_BYTES + size * RECORD_BYTES > (unsigned long)length) {
+		fprintf(stderr, "%s : not a trace dump (size %lu, frequency %.0f)\n", argv[1], size, frequency);
+		return 1;
+	}
+	// Oldest record first : once wrapped, the next one to be written
+	records = (count < size) ? count : size;
+	start = (count < size) ? 0 : count % size;
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for(i = 0; i < records; i++) {
+		const unsigned char* r = dump + HEADER_BYTES + ((start + i) % size) * RECORD_BYTES;
+		unsigned int type = r[4], id = r[5], arg = le(r + 6, 2);
+		time = le(r, 4);
+		if(i == 0) {
+			origin = time;
+		}
+		else if(time < last) {
+			wraps += 1ULL << 32;	// Timer 8/9 wrapped (every 107s at 40MHz)
+		}
+		last = time;
+		ts = (double)(time + wraps - origin) * 1e6 / frequency;
+
+		switch(type) {
+			case TRACE_SWITCH:
+				if(current < 0) {
+					current = arg;	// was running since the start of the dump
+				}
+				if(current < PRIOS) {
+					seen[current] = 1;
+					slice(current, taskName(current, name), since, ts);
+				}
+				current = id;
+				since = ts;
+				break;
+			case TRACE_TICK:
+				instant(ROW_TICKS, "tick", ts, arg);
+				break;
+			case TRACE_ISR_ENTER:
+				if(id < ISRS) {
+					isrStart[id] = ts;
+				}
+				break;
+			case TRACE_ISR_EXIT:
+				if(id < ISRS && isrStart[id] >= 0) {
+					slice(ROW_ISR + id, isrNames[id] ? isrNames[id] : "ISR", isrStart[id], ts);
+					isrStart[id] = -1;
+				}
+				break;
+			case TRACE_MUTEX_PEND:
+				if(id < EVENTS && arg < PRIOS) {
+					isMutex[id] = 1;
+					waitStart[id][arg] = ts;
+				}
+				break;
+			case TRACE_MUTEX_TAKEN:
+				if(id < EVENTS && arg < PRIOS) {
+					isMutex[id] = 1;
+					if(waitStart[id][arg] >= 0 && ts > waitStart[id][arg]) {
+						sprintf(other, "%s waits", taskName(arg, name));
+						slice(ROW_MUTEX_WAIT + id, other, waitStart[id][arg], ts);
+					}
+					waitStart[id][arg] = -1;
+					holdStart[id] = ts;
+					holder[id] = arg;
+				}
+				break;
+			case TRACE_MUTEX_POST:
+				if(id < EVENTS) {
+					isMutex[id] = 1;
+					if(holdStart[id] >= 0) {
+						slice(ROW_MUTEX_HOLD + id, taskName(holder[id], name), holdStart[id], ts);
+					}
+					holdStart[id] = -1;
+				}
+				break;
+			case TRACE_Q_POST:
+			case TRACE_Q_GET:
+				if(id < EVENTS) {
+					isQueue[id] = 1;
+					instant(ROW_QUEUE + id, type == TRACE_Q_POST ? "post" : "get", ts, arg);
+				}
+				break;
+			case TRACE_TRIGGER:
+				separator();
+				printf("{\"name\":\"trigger\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", ROW_TICKS, ts);
+				break;
+		}
+	}
+	if(current >= 0 && current < PRIOS && records) {
+		seen[current] = 1;
+		slice(current, taskName(current, name), since, (double)(last + wraps - origin) * 1e6 / frequency);
+	}
+
+	// Names of the rows
+	for(k = 0; k < PRIOS; k++) {
+		if(seen[k]) {
+			row(k, taskName(k, name));
+		}
+	}
+	row(ROW_TICKS, "Ticks");
+	for(k = 1; k < ISRS; k++) {
+		if(isrNames[k]) {
+			row(ROW_ISR + k, isrNames[k]);
+		}
+	}
+	for(k = 0; k < EVENTS; k++) {
+		if(isMutex[k]) {
+			sprintf(name, "Mutex %d held", k);
+			row(ROW_MUTEX_HOLD + k, name);
+			sprintf(name, "Mutex %d waits", k);
+			row(ROW_MUTEX_WAIT + k, name);
+		}
+		if(isQueue[k]) {
+			sprintf(name, "Queue %d", k);
+			row(ROW_QUEUE + k, name);
+		}
+	}
+	printf("\n]}\n");
+	fprintf(stderr, "%lu records (%lu written, %.0f Hz time stamps)\n", records, count, frequency);
+	free(dump);
+	return 0;
+}